@@ -0,0 +1,23 @@
+Bench.register("bin_packing/knapsack", sizes: {small: 100, medium: 1000, large: 10000}, python: "knapsack.py") do |n, b|
+  rng = Bench::Rng.new
+  values = n.times.map { rng.int(1, 1000) }
+  weights = [n.times.map { rng.int(1, 100) }]
+  capacities = [weights[0].sum / 2]
+
+  solver = b.build do
+    solver = ORTools::KnapsackSolver.new(:branch_and_bound, "Benchmark")
+    solver.init(values, weights, capacities)
+    solver
+  end
+  b.solve { solver.solve }
+  b.extract { n.times.select { |i| solver.best_solution_contains?(i) } }
+end
+
+Bench.register("bin_packing/bin_packer", sizes: {small: 50, medium: 200, large: 500}) do |n, b|
+  rng = Bench::Rng.new
+  sizes = n.times.map { rng.int(10, 60) }
+
+  packer = b.build { ORTools::BinPacker.new(sizes, [100] * n) }
+  result = b.solve { packer.solve(time_limit: 10) }
+  b.extract { result[:assignments] }
+end
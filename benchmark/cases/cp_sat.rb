@@ -0,0 +1,80 @@
+# jobs with one task per machine in random order
+Bench.register("cp_sat/job_shop", sizes: {small: 10, medium: 20, large: 40}, python: "job_shop.py") do |n, b|
+  rng = Bench::Rng.new
+  machines = 5
+  jobs = n.times.map do
+    machines.times.map { |m| [rng.int(0, 1000), m] }.sort.map(&:last).map { |m| [m, rng.int(1, 10)] }
+  end
+  horizon = jobs.flatten(1).sum { |t| t[1] }
+
+  model, ends, starts = b.build do
+    model = ORTools::CpModel.new
+    machine_intervals = Hash.new { |h, k| h[k] = [] }
+    starts = []
+    ends = []
+    jobs.each do |job|
+      previous_end = nil
+      job.each do |machine, duration|
+        start_var = model.new_int_var(0, horizon, "")
+        machine_intervals[machine] << model.new_fixed_size_interval_var(start_var, duration, "")
+        model.add(start_var >= previous_end) if previous_end
+        starts << start_var
+        previous_end = start_var + duration
+      end
+      ends << previous_end
+    end
+    machine_intervals.each_value { |intervals| model.add_no_overlap(intervals) }
+    makespan = model.new_int_var(0, horizon, "makespan")
+    model.add_max_equality(makespan, ends)
+    model.minimize(makespan)
+    [model, ends, starts]
+  end
+
+  solver = ORTools::CpSolver.new
+  solver.parameters.max_time_in_seconds = 10
+  solver.parameters.num_workers = 8
+  b.solve { solver.solve(model) }
+  b.extract { starts.map { |v| solver.value(v) } }
+end
+
+# nurses covering every shift with at most one shift per day
+Bench.register("cp_sat/shift_scheduling", sizes: {small: 10, medium: 30, large: 60}) do |n, b|
+  rng = Bench::Rng.new
+  days = 14
+  shifts = 3
+  requests = n.times.map { days.times.map { shifts.times.map { rng.int(0, 1) } } }
+
+  model, vars = b.build do
+    model = ORTools::CpModel.new
+    vars = {}
+    n.times do |i|
+      days.times do |d|
+        shifts.times do |s|
+          vars[[i, d, s]] = model.new_bool_var("")
+        end
+      end
+    end
+    days.times do |d|
+      shifts.times do |s|
+        model.add_exactly_one(n.times.map { |i| vars[[i, d, s]] })
+      end
+      n.times do |i|
+        model.add_at_most_one(shifts.times.map { |s| vars[[i, d, s]] })
+      end
+    end
+    min_shifts = days * shifts / n
+    n.times do |i|
+      worked = model.sum(days.times.flat_map { |d| shifts.times.map { |s| vars[[i, d, s]] } })
+      model.add(worked >= min_shifts)
+      model.add(worked <= min_shifts + 1)
+    end
+    model.maximize(model.sum(vars.map { |(i, d, s), v| v * requests[i][d][s] }))
+    [model, vars]
+  end
+
+  solver = ORTools::CpSolver.new
+  solver.parameters.max_time_in_seconds = 10
+  solver.parameters.num_workers = 8
+  b.solve { solver.solve(model) }
+  b.extract { vars.transform_values { |v| solver.value(v) } }
+end
@@ -0,0 +1,46 @@
+# random packing problem with ten variables per constraint
+def bench_packing_instance(n)
+  rng = Bench::Rng.new
+  objective = n.times.map { rng.int(1, 100) }
+  rows = (n / 2).times.map do
+    [10.times.map { [rng.int(0, n - 1), rng.int(1, 20)] }.uniq(&:first), rng.int(50, 200)]
+  end
+  [objective, rows]
+end
+
+[["linear/lp", "GLOP", false], ["linear/mip", "CBC", true]].each do |name, solver_id, integer|
+  sizes = integer ? {small: 200, medium: 1000, large: 5000} : {small: 1000, medium: 10000, large: 100000}
+  Bench.register(name, sizes: sizes, python: integer ? nil : "linear_lp.py") do |n, b|
+    objective, rows = bench_packing_instance(n)
+
+    solver, vars = b.build do
+      solver = ORTools::Solver.new(solver_id)
+      vars = n.times.map { |i| integer ? solver.int_var(0, 10, "x#{i}") : solver.num_var(0, 10, "x#{i}") }
+      rows.each do |terms, rhs|
+        solver.add(solver.sum(terms.map { |j, a| vars[j] * a }) <= rhs)
+      end
+      solver.maximize(solver.sum(objective.each_with_index.map { |c, j| vars[j] * c }))
+      [solver, vars]
+    end
+
+    b.solve { solver.solve }
+    b.extract { vars.map(&:solution_value) }
+  end
+end
+
+Bench.register("math_opt/lp", sizes: {small: 1000, medium: 10000, large: 100000}) do |n, b|
+  objective, rows = bench_packing_instance(n)
+
+  model, vars = b.build do
+    model = ORTools::MathOpt::Model.new("packing")
+    vars = n.times.map { |i| model.add_variable(0, 10, "x#{i}") }
+    rows.each do |terms, rhs|
+      model.add_linear_constraint(terms.sum { |j, a| vars[j] * a } <= rhs)
+    end
+    model.maximize(objective.each_with_index.sum { |c, j| vars[j] * c })
+    [model, vars]
+  end
+
+  result = b.solve { model.solve(:glop) }
+  b.extract { result.variable_values_array }
+end
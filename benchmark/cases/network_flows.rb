@@ -0,0 +1,69 @@
+# random graph with a few long arcs per node
+def bench_flow_instance(n)
+  rng = Bench::Rng.new
+  tails = []
+  heads = []
+  capacities = []
+  costs = []
+  n.times do |i|
+    4.times do
+      tails << i
+      heads << rng.int(0, n - 1)
+      capacities << rng.int(1, 100)
+      costs << rng.int(1, 20)
+    end
+    # path so every node is reachable
+    if i + 1 < n
+      tails << i
+      heads << i + 1
+      capacities << 1000
+      costs << 50
+    end
+  end
+  [tails, heads, capacities, costs]
+end
+
+Bench.register("network_flows/max_flow", sizes: {small: 1000, medium: 100000, large: 1000000}) do |n, b|
+  tails, heads, capacities, _ = bench_flow_instance(n)
+
+  max_flow = b.build do
+    max_flow = ORTools::SimpleMaxFlow.new
+    max_flow.add_arcs_with_capacity(tails, heads, capacities)
+    max_flow
+  end
+  b.solve { max_flow.solve(0, n - 1) }
+  b.extract { max_flow.flows.unpack("q*") }
+end
+
+Bench.register("network_flows/min_cost_flow", sizes: {small: 1000, medium: 100000, large: 1000000}, python: "min_cost_flow.py") do |n, b|
+  tails, heads, capacities, costs = bench_flow_instance(n)
+
+  min_cost_flow = b.build do
+    min_cost_flow = ORTools::SimpleMinCostFlow.new(n, tails.size)
+    tails.size.times do |i|
+      min_cost_flow.add_arc_with_capacity_and_unit_cost(tails[i], heads[i], capacities[i], costs[i])
+    end
+    min_cost_flow.set_node_supply(0, 100)
+    min_cost_flow.set_node_supply(n - 1, -100)
+    min_cost_flow
+  end
+  b.solve { min_cost_flow.solve }
+  b.extract { min_cost_flow.num_arcs.times.map { |i| min_cost_flow.flow(i) } }
+end
+
+Bench.register("assignment/linear_sum", sizes: {small: 100, medium: 500, large: 2000}) do |n, b|
+  rng = Bench::Rng.new
+  costs = (n * n).times.map { rng.int(1, 1000) }
+
+  assignment = b.build do
+    assignment = ORTools::LinearSumAssignment.new
+    assignment.add_arcs_with_cost(
+      n.times.flat_map { |i| [i] * n },
+      n.times.to_a * n,
+      costs
+    )
+    assignment
+  end
+  b.solve { assignment.solve }
+  b.extract { assignment.right_mates }
+end
@@ -0,0 +1,45 @@
+# capacitated vehicle routing with time windows on a random grid
+Bench.register("routing/cvrptw", sizes: {small: 30, medium: 100, large: 300}, python: "cvrptw.py") do |n, b|
+  rng = Bench::Rng.new
+  points = n.times.map { [rng.int(0, 100), rng.int(0, 100)] }
+  demands = n.times.map { |i| i == 0 ? 0 : rng.int(1, 10) }
+  windows = n.times.map { |i| i == 0 ? [0, 1000] : (s = rng.int(0, 800); [s, s + 200]) }
+  num_vehicles = (n / 8.0).ceil
+  capacity = 40
+  times = points.map { |a| points.map { |p| (a[0] - p[0]).abs + (a[1] - p[1]).abs } }
+
+  manager, routing = b.build do
+    manager = ORTools::RoutingIndexManager.new(n, num_vehicles, 0)
+    routing = ORTools::RoutingModel.new(manager)
+
+    time_callback = routing.register_transit_callback(lambda do |from_index, to_index|
+      times[manager.index_to_node(from_index)][manager.index_to_node(to_index)]
+    end)
+    routing.set_arc_cost_evaluator_of_all_vehicles(time_callback)
+    routing.add_dimension(time_callback, 1000, 1000, false, "Time")
+    time_dimension = routing.mutable_dimension("Time")
+    n.times do |i|
+      next if i == 0
+      time_dimension.cumul_var(manager.node_to_index(i)).set_range(*windows[i])
+    end
+
+    demand_callback = routing.register_unary_transit_callback(lambda do |from_index|
+      demands[manager.index_to_node(from_index)]
+    end)
+    routing.add_dimension_with_vehicle_capacity(demand_callback, 0, [capacity] * num_vehicles, true, "Capacity")
+    [manager, routing]
+  end
+
+  solution = b.solve { routing.solve(first_solution_strategy: :path_cheapest_arc, time_limit: 10) }
+  b.extract do
+    num_vehicles.times.map do |vehicle_id|
+      route = []
+      index = routing.start(vehicle_id)
+      until routing.end?(index)
+        route << manager.index_to_node(index)
+        index = solution.value(routing.next_var(index))
+      end
+      route
+    end
+  end
+end
@@ -0,0 +1,66 @@
+# compares KnapsackSolver types on both sides of the :auto thresholds
+# ruby -Ilib benchmark/knapsack.rb
+#
+# :auto (auto_knapsack_solver_type in ext/or-tools/bin_packing.cpp) picks
+# - 1-D, at most 64 items: items_64
+# - 1-D, items * capacity <= 1e8: dynamic_programming
+# - 1-D, otherwise: branch_and_bound
+# - multi-dimensional, at most 100 items: branch_and_bound
+# - multi-dimensional, otherwise: cp_sat
+#
+# dynamic programming does items * capacity work and allocates O(capacity)
+# memory, so it only runs up to the same 1e8 cutoff here
+# cbc_mip and scip_mip are timed for comparison, but are never picked by :auto
+
+require "bundler/setup"
+require "benchmark"
+require "or-tools"
+
+def instance(rng, num_items, dimensions, max_weight)
+  values = num_items.times.map { rng.rand(1..1000) }
+  weights = dimensions.times.map { num_items.times.map { rng.rand(1..max_weight) } }
+  capacities = weights.map { |w| w.sum / 2 }
+  [values, weights, capacities]
+end
+
+# items * capacity is about items^2 * max_weight / 4
+shapes = [
+  {name: "1-D, 20 items", num_items: 20, dimensions: 1, max_weight: 100},
+  {name: "1-D, 64 items", num_items: 64, dimensions: 1, max_weight: 100},
+  {name: "1-D, 65 items", num_items: 65, dimensions: 1, max_weight: 100},
+  {name: "1-D, 1000 items, items * capacity ~ 5e7", num_items: 1000, dimensions: 1, max_weight: 200},
+  {name: "1-D, 1000 items, items * capacity ~ 2e8", num_items: 1000, dimensions: 1, max_weight: 800},
+  {name: "1-D, 2000 items, items * capacity ~ 1e12", num_items: 2000, dimensions: 1, max_weight: 1_000_000},
+  {name: "3-D, 50 items", num_items: 50, dimensions: 3, max_weight: 100},
+  {name: "3-D, 100 items", num_items: 100, dimensions: 3, max_weight: 100},
+  {name: "3-D, 101 items", num_items: 101, dimensions: 3, max_weight: 100},
+  {name: "3-D, 500 items", num_items: 500, dimensions: 3, max_weight: 100}
+]
+
+one_dimension = [:brute_force, :items_64, :dynamic_programming, :divide_and_conquer]
+solver_types = one_dimension + [:branch_and_bound, :cp_sat, :cbc_mip, :scip_mip, :auto]
+time_limit = 10
+
+shapes.each do |shape|
+  rng = Random.new(42)
+  values, weights, capacities = instance(rng, shape[:num_items], shape[:dimensions], shape[:max_weight])
+
+  puts "#{shape[:name]} (items * capacity = #{shape[:num_items] * capacities[0]})"
+  solver_types.each do |solver_type|
+    next if one_dimension.include?(solver_type) && shape[:dimensions] > 1
+    next if solver_type == :brute_force && shape[:num_items] > 30
+    next if solver_type == :items_64 && shape[:num_items] > 64
+    next if solver_type == :dynamic_programming && shape[:num_items] * capacities[0] > 1e8
+
+    solver = ORTools::KnapsackSolver.new(solver_type, "Benchmark")
+    solver.set_time_limit(time_limit)
+    value = nil
+    time = Benchmark.realtime do
+      solver.init(values, weights, capacities)
+      value = solver.solve
+    end
+    label = solver_type == :auto ? "auto (#{solver.solver_type})" : solver_type.to_s
+    puts "  %-35s %10.4fs  value=%d%s" % [label, time, value, solver.solution_optimal? ? "" : " (not optimal)"]
+  end
+  puts
+end
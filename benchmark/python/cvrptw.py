@@ -0,0 +1,63 @@
+import sys
+from ortools.constraint_solver import pywrapcp, routing_enums_pb2
+from rng import Rng, Recorder
+
+n = int(sys.argv[1])
+rng = Rng()
+points = [(rng.int(0, 100), rng.int(0, 100)) for _ in range(n)]
+demands = [0 if i == 0 else rng.int(1, 10) for i in range(n)]
+windows = []
+for i in range(n):
+    if i == 0:
+        windows.append((0, 1000))
+    else:
+        s = rng.int(0, 800)
+        windows.append((s, s + 200))
+num_vehicles = -(-n // 8)
+capacity = 40
+times = [[abs(a[0] - p[0]) + abs(a[1] - p[1]) for p in points] for a in points]
+
+r = Recorder()
+r.begin()
+manager = pywrapcp.RoutingIndexManager(n, num_vehicles, 0)
+routing = pywrapcp.RoutingModel(manager)
+
+
+def time_callback(from_index, to_index):
+    return times[manager.IndexToNode(from_index)][manager.IndexToNode(to_index)]
+
+
+time_index = routing.RegisterTransitCallback(time_callback)
+routing.SetArcCostEvaluatorOfAllVehicles(time_index)
+routing.AddDimension(time_index, 1000, 1000, False, "Time")
+time_dimension = routing.GetDimensionOrDie("Time")
+for i in range(1, n):
+    time_dimension.CumulVar(manager.NodeToIndex(i)).SetRange(*windows[i])
+
+
+def demand_callback(from_index):
+    return demands[manager.IndexToNode(from_index)]
+
+
+demand_index = routing.RegisterUnaryTransitCallback(demand_callback)
+routing.AddDimensionWithVehicleCapacity(demand_index, 0, [capacity] * num_vehicles, True, "Capacity")
+r.end("build")
+
+parameters = pywrapcp.DefaultRoutingSearchParameters()
+parameters.first_solution_strategy = routing_enums_pb2.FirstSolutionStrategy.PATH_CHEAPEST_ARC
+parameters.time_limit.seconds = 10
+r.begin()
+solution = routing.SolveWithParameters(parameters)
+r.end("solve")
+
+r.begin()
+routes = []
+for vehicle_id in range(num_vehicles):
+    route = []
+    index = routing.Start(vehicle_id)
+    while not routing.IsEnd(index):
+        route.append(manager.IndexToNode(index))
+        index = solution.Value(routing.NextVar(index))
+    routes.append(route)
+r.end("extract")
+r.report()
@@ -0,0 +1,48 @@
+import sys
+from ortools.sat.python import cp_model
+from rng import Rng, Recorder
+
+n = int(sys.argv[1])
+rng = Rng()
+machines = 5
+jobs = []
+for _ in range(n):
+    keys = [(rng.int(0, 1000), m) for m in range(machines)]
+    order = [m for _, m in sorted(keys, key=lambda k: k[0])]
+    jobs.append([(m, rng.int(1, 10)) for m in order])
+horizon = sum(d for job in jobs for _, d in job)
+
+r = Recorder()
+r.begin()
+model = cp_model.CpModel()
+machine_intervals = {}
+starts = []
+ends = []
+for job in jobs:
+    previous_end = None
+    for machine, duration in job:
+        start = model.NewIntVar(0, horizon, "")
+        machine_intervals.setdefault(machine, []).append(model.NewFixedSizeIntervalVar(start, duration, ""))
+        if previous_end is not None:
+            model.Add(start >= previous_end)
+        starts.append(start)
+        previous_end = start + duration
+    ends.append(previous_end)
+for intervals in machine_intervals.values():
+    model.AddNoOverlap(intervals)
+makespan = model.NewIntVar(0, horizon, "makespan")
+model.AddMaxEquality(makespan, ends)
+model.Minimize(makespan)
+r.end("build")
+
+solver = cp_model.CpSolver()
+solver.parameters.max_time_in_seconds = 10
+solver.parameters.num_workers = 8
+r.begin()
+solver.Solve(model)
+r.end("solve")
+
+r.begin()
+[solver.Value(v) for v in starts]
+r.end("extract")
+r.report()
@@ -0,0 +1,26 @@
+import sys
+from ortools.algorithms.python import knapsack_solver
+from rng import Rng, Recorder
+
+n = int(sys.argv[1])
+rng = Rng()
+values = [rng.int(1, 1000) for _ in range(n)]
+weights = [[rng.int(1, 100) for _ in range(n)]]
+capacities = [sum(weights[0]) // 2]
+
+r = Recorder()
+r.begin()
+solver = knapsack_solver.KnapsackSolver(
+    knapsack_solver.SolverType.KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER, "Benchmark"
+)
+solver.init(values, weights, capacities)
+r.end("build")
+
+r.begin()
+solver.solve()
+r.end("solve")
+
+r.begin()
+[i for i in range(n) if solver.best_solution_contains(i)]
+r.end("extract")
+r.report()
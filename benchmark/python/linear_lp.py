@@ -0,0 +1,33 @@
+import sys
+from ortools.linear_solver import pywraplp
+from rng import Rng, Recorder
+
+n = int(sys.argv[1])
+rng = Rng()
+objective = [rng.int(1, 100) for _ in range(n)]
+rows = []
+for _ in range(n // 2):
+    terms = {}
+    for _ in range(10):
+        j = rng.int(0, n - 1)
+        a = rng.int(1, 20)
+        terms.setdefault(j, a)
+    rows.append((terms, rng.int(50, 200)))
+
+r = Recorder()
+r.begin()
+solver = pywraplp.Solver.CreateSolver("GLOP")
+x = [solver.NumVar(0, 10, "x%d" % i) for i in range(n)]
+for terms, rhs in rows:
+    solver.Add(sum(x[j] * a for j, a in terms.items()) <= rhs)
+solver.Maximize(sum(x[j] * c for j, c in enumerate(objective)))
+r.end("build")
+
+r.begin()
+solver.Solve()
+r.end("solve")
+
+r.begin()
+[v.solution_value() for v in x]
+r.end("extract")
+r.report()
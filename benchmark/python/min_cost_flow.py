@@ -0,0 +1,36 @@
+import sys
+from ortools.graph.python import min_cost_flow
+from rng import Rng, Recorder
+
+n = int(sys.argv[1])
+rng = Rng()
+tails, heads, capacities, costs = [], [], [], []
+for i in range(n):
+    for _ in range(4):
+        tails.append(i)
+        heads.append(rng.int(0, n - 1))
+        capacities.append(rng.int(1, 100))
+        costs.append(rng.int(1, 20))
+    if i + 1 < n:
+        tails.append(i)
+        heads.append(i + 1)
+        capacities.append(1000)
+        costs.append(50)
+
+r = Recorder()
+r.begin()
+smcf = min_cost_flow.SimpleMinCostFlow(n, len(tails))
+for i in range(len(tails)):
+    smcf.add_arc_with_capacity_and_unit_cost(tails[i], heads[i], capacities[i], costs[i])
+smcf.set_node_supply(0, 100)
+smcf.set_node_supply(n - 1, -100)
+r.end("build")
+
+r.begin()
+smcf.solve()
+r.end("solve")
+
+r.begin()
+[smcf.flow(i) for i in range(smcf.num_arcs())]
+r.end("extract")
+r.report()
@@ -0,0 +1,35 @@
+# same sequence as Bench::Rng in benchmark/support.rb
+import json
+import resource
+import sys
+import time
+
+MASK = 0xFFFFFFFFFFFFFFFF
+
+
+class Rng:
+    def __init__(self, seed=42):
+        self.state = seed
+
+    def int(self, lo, hi):
+        self.state = (self.state * 6364136223846793005 + 1442695040888963407) & MASK
+        return lo + (self.state >> 33) % (hi - lo + 1)
+
+
+class Recorder:
+    def __init__(self):
+        self.phases = {}
+        self.start = None
+
+    def begin(self):
+        self.start = time.perf_counter()
+
+    def end(self, phase):
+        self.phases[phase] = time.perf_counter() - self.start
+
+    def report(self):
+        rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+        if sys.platform == "darwin":
+            rss //= 1024
+        self.phases["peak_rss_kb"] = rss
+        print(json.dumps(self.phases))
@@ -0,0 +1,78 @@
+# ruby -Ilib benchmark/run.rb [pattern...]
+#
+# BENCH_SIZE=small|medium|large (default small)
+# BENCH_OUTPUT=path for JSON results (default tmp/bench.json)
+# BENCH_PYTHON=0 to skip Python baselines
+
+require "bundler/setup"
+require "fileutils"
+require "json"
+require "time"
+require "or-tools"
+require_relative "support"
+
+Dir[File.join(__dir__, "cases", "*.rb")].sort.each { |path| require path }
+
+size = (ENV["BENCH_SIZE"] || "small").to_sym
+output = ENV["BENCH_OUTPUT"] || "tmp/bench.json"
+patterns = ARGV
+
+python = ENV["BENCH_PYTHON"] != "0" && system("python3", "-c", "import ortools", out: File::NULL, err: File::NULL)
+warn "Python baselines skipped (python3 with ortools not found)" if ENV["BENCH_PYTHON"] != "0" && !python
+
+# runs in a child process when possible so peak RSS is per case
+def run_case(bench_case, param)
+  run = lambda do
+    recorder = Bench::Recorder.new
+    bench_case.block.call(param, recorder)
+    {phases: recorder.phases, peak_rss_kb: Bench.peak_rss_kb}
+  end
+  return run.call unless Process.respond_to?(:fork)
+
+  reader, writer = IO.pipe
+  pid = fork do
+    reader.close
+    writer.write(JSON.generate(run.call))
+    writer.close
+    exit!(0)
+  end
+  writer.close
+  result = reader.read
+  Process.wait(pid)
+  raise "Benchmark failed: #{bench_case.name}" unless $?.success?
+  JSON.parse(result, symbolize_names: true)
+end
+
+def run_python(script, param)
+  out = IO.popen(["python3", File.join(__dir__, "python", script), param.to_s], &:read)
+  $?.success? ? JSON.parse(out, symbolize_names: true) : nil
+end
+
+results = []
+Bench::CASES.each do |bench_case|
+  next if patterns.any? && patterns.none? { |p| bench_case.name.include?(p) }
+
+  param = bench_case.sizes.fetch(size)
+  result = {name: bench_case.name, size: size, param: param}
+  result.merge!(run_case(bench_case, param))
+  result[:python] = run_python(bench_case.python, param) if python && bench_case.python
+  results << result
+
+  phases = result[:phases].map { |k, v| "%s %.3fs (%d allocs)" % [k, v[:time], v[:allocations]] }
+  line = "%-32s %s, %d MB" % [bench_case.name, phases.join(", "), result[:peak_rss_kb] / 1024]
+  if result[:python]
+    line += " | python " + [:build, :solve, :extract].map { |k| "%s %.3fs" % [k, result[:python][k]] }.join(", ")
+  end
+  puts line
+end
+
+FileUtils.mkdir_p(File.dirname(output))
+File.write(output, JSON.pretty_generate({
+  time: Time.now.utc.iso8601,
+  ruby_version: RUBY_VERSION,
+  gem_version: ORTools::VERSION,
+  or_tools_version: ORTools.lib_version,
+  size: size,
+  results: results
+}))
+puts "Results written to #{output}"
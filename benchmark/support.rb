@@ -0,0 +1,67 @@
+module Bench
+  Case = Struct.new(:name, :sizes, :python, :block)
+
+  CASES = []
+
+  # sizes maps :small, :medium, and :large to the parameter passed to the block
+  # python is the script in benchmark/python that builds the same instance
+  def self.register(name, sizes:, python: nil, &block)
+    CASES << Case.new(name, sizes, python, block)
+  end
+
+  # times each phase and counts Ruby allocations
+  class Recorder
+    attr_reader :phases
+
+    def initialize
+      @phases = {}
+    end
+
+    def build(&block)
+      measure(:build, &block)
+    end
+
+    def solve(&block)
+      measure(:solve, &block)
+    end
+
+    def extract(&block)
+      measure(:extract, &block)
+    end
+
+    private
+
+    def measure(phase)
+      allocated = GC.stat(:total_allocated_objects)
+      start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      result = yield
+      @phases[phase] = {
+        time: Process.clock_gettime(Process::CLOCK_MONOTONIC) - start,
+        allocations: GC.stat(:total_allocated_objects) - allocated
+      }
+      result
+    end
+  end
+
+  # same sequence as benchmark/python/rng.py so instances match
+  class Rng
+    MASK = 0xFFFFFFFFFFFFFFFF
+
+    def initialize(seed = 42)
+      @state = seed
+    end
+
+    def int(min, max)
+      @state = (@state * 6364136223846793005 + 1442695040888963407) & MASK
+      min + (@state >> 33) % (max - min + 1)
+    end
+  end
+
+  def self.peak_rss_kb
+    if File.exist?("/proc/self/status")
+      File.read("/proc/self/status")[/^VmHWM:\s+(\d+)/, 1].to_i
+    else
+      `ps -o rss= -p #{Process.pid}`.to_i
+    end
+  end
+end
@@ -1,15 +1,148 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
 #include <ortools/graph/assignment.h>
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "buffer.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+
 using operations_research::SimpleLinearSumAssignment;
 
+using Rice::Array;
+using Rice::Hash;
+using Rice::Object;
 using Rice::Symbol;
 
+Symbol assignment_status(SimpleLinearSumAssignment::Status status) {
+  if (status == SimpleLinearSumAssignment::Status::OPTIMAL) {
+    return Symbol("optimal");
+  } else if (status == SimpleLinearSumAssignment::Status::INFEASIBLE) {
+    return Symbol("infeasible");
+  } else if (status == SimpleLinearSumAssignment::Status::POSSIBLE_OVERFLOW) {
+    return Symbol("possible_overflow");
+  } else {
+    throw std::runtime_error{"Unknown status"};
+  }
+}
+
+// checked before adding any arcs or solving on native threads
+// the graph has a node for each left and right node, so larger indices overflow
+void check_assignment_nodes(const std::vector<int32_t>& nodes) {
+  for (auto node : nodes) {
+    if (node < 0 || node >= std::numeric_limits<int32_t>::max() / 2) {
+      throw std::invalid_argument("Invalid node");
+    }
+  }
+}
+
+struct AssignmentInstance {
+  std::vector<int32_t> left_nodes;
+  std::vector<int32_t> right_nodes;
+  std::vector<int64_t> costs;
+  SimpleLinearSumAssignment::Status status;
+  int64_t optimal_cost = 0;
+  std::vector<int32_t> right_mates;
+};
+
+const int64_t kForbidden = std::numeric_limits<int64_t>::max();
+
+// shortest augmenting path (Jonker-Volgenant style Hungarian) for a dense
+// row-major matrix with rows <= cols, scanning one contiguous row per step
+// returns false if some row cannot be assigned
+bool solve_dense_assignment(const std::vector<int64_t>& costs, size_t rows, size_t cols, std::vector<int32_t>& mates, int64_t& total) {
+  const int64_t inf = kForbidden;
+  std::vector<int64_t> u(rows + 1), v(cols + 1), minv(cols + 1);
+  std::vector<size_t> p(cols + 1), way(cols + 1);
+  std::vector<bool> used(cols + 1);
+
+  for (size_t i = 1; i <= rows; i++) {
+    p[0] = i;
+    size_t j0 = 0;
+    std::fill(minv.begin(), minv.end(), inf);
+    std::fill(used.begin(), used.end(), false);
+
+    do {
+      used[j0] = true;
+      size_t i0 = p[j0];
+      const int64_t* row = costs.data() + (i0 - 1) * cols;
+      int64_t delta = inf;
+      size_t j1 = 0;
+
+      for (size_t j = 1; j <= cols; j++) {
+        if (used[j]) {
+          continue;
+        }
+        if (row[j - 1] != kForbidden) {
+          int64_t cur = row[j - 1] - u[i0] - v[j];
+          if (cur < minv[j]) {
+            minv[j] = cur;
+            way[j] = j0;
+          }
+        }
+        if (minv[j] < delta) {
+          delta = minv[j];
+          j1 = j;
+        }
+      }
+
+      if (j1 == 0) {
+        return false;
+      }
+
+      for (size_t j = 0; j <= cols; j++) {
+        if (used[j]) {
+          u[p[j]] += delta;
+          v[j] -= delta;
+        } else if (minv[j] != inf) {
+          minv[j] -= delta;
+        }
+      }
+      j0 = j1;
+    } while (p[j0] != 0);
+
+    do {
+      size_t j1 = way[j0];
+      p[j0] = p[j1];
+      j0 = j1;
+    } while (j0 != 0);
+  }
+
+  mates.assign(rows, -1);
+  total = 0;
+  for (size_t j = 1; j <= cols; j++) {
+    if (p[j] != 0) {
+      mates[p[j] - 1] = j - 1;
+      total += costs[(p[j] - 1) * cols + j - 1];
+    }
+  }
+  return true;
+}
+
 void init_assignment(Rice::Module& m) {
   Rice::define_class_under<SimpleLinearSumAssignment>(m, "LinearSumAssignment")
     .define_constructor(Rice::Constructor<SimpleLinearSumAssignment>())
     .define_method("add_arc_with_cost", &SimpleLinearSumAssignment::AddArcWithCost)
+    .define_method(
+      "add_arcs_with_cost",
+      [](SimpleLinearSumAssignment& self, Object left_nodes, Object right_nodes, Object costs) {
+        auto l = read_buffer<int32_t>(left_nodes);
+        auto r = read_buffer<int32_t>(right_nodes);
+        auto c = read_buffer<int64_t>(costs);
+        check_sizes(l.size(), r.size());
+        check_sizes(l.size(), c.size());
+        check_assignment_nodes(l);
+        check_assignment_nodes(r);
+
+        for (size_t i = 0; i < l.size(); i++) {
+          self.AddArcWithCost(l[i], r[i], c[i]);
+        }
+      })
     .define_method("num_nodes", &SimpleLinearSumAssignment::NumNodes)
     .define_method("num_arcs", &SimpleLinearSumAssignment::NumArcs)
     .define_method("left_node", &SimpleLinearSumAssignment::LeftNode)
@@ -18,19 +151,159 @@ void init_assignment(Rice::Module& m) {
     .define_method("optimal_cost", &SimpleLinearSumAssignment::OptimalCost)
     .define_method("right_mate", &SimpleLinearSumAssignment::RightMate)
     .define_method("assignment_cost", &SimpleLinearSumAssignment::AssignmentCost)
+    .define_method(
+      "right_mates",
+      [](SimpleLinearSumAssignment& self) {
+        auto num_nodes = self.NumNodes();
+        Array ret(rb_ary_new_capa(num_nodes));
+        for (SimpleLinearSumAssignment::NodeIndex i = 0; i < num_nodes; i++) {
+          ret.push(self.RightMate(i), false);
+        }
+        return ret;
+      })
+    .define_method(
+      "assignment_costs",
+      [](SimpleLinearSumAssignment& self) {
+        auto num_nodes = self.NumNodes();
+        Array ret(rb_ary_new_capa(num_nodes));
+        for (SimpleLinearSumAssignment::NodeIndex i = 0; i < num_nodes; i++) {
+          ret.push(self.AssignmentCost(i), false);
+        }
+        return ret;
+      })
     .define_method(
       "solve",
       [](SimpleLinearSumAssignment& self) {
-        auto status = self.Solve();
-
-        if (status == SimpleLinearSumAssignment::Status::OPTIMAL) {
-          return Symbol("optimal");
-        } else if (status == SimpleLinearSumAssignment::Status::INFEASIBLE) {
-          return Symbol("infeasible");
-        } else if (status == SimpleLinearSumAssignment::Status::POSSIBLE_OVERFLOW) {
-          return Symbol("possible_overflow");
+        auto status = no_gvl("solve.linear_sum_assignment", [&]() {
+          return self.Solve();
+        });
+        return assignment_status(status);
+      })
+    .define_singleton_function(
+      "solve_dense",
+      [](Object cost_matrix, int64_t rows, int64_t cols) {
+        if (rows < 0 || cols < 0) {
+          throw std::invalid_argument("Invalid dimensions");
+        }
+
+        // nil marks a forbidden entry in Arrays
+        std::vector<int64_t> costs;
+        if (cost_matrix.is_a(rb_cString)) {
+          costs = read_buffer<int64_t>(cost_matrix);
+        } else {
+          Array a(cost_matrix);
+          costs.reserve(a.size());
+          for (size_t i = 0; i < a.size(); i++) {
+            Object v(a[i]);
+            costs.push_back(v.is_nil() ? kForbidden : Rice::detail::From_Ruby<int64_t>().convert(v.value()));
+          }
+        }
+        check_sizes(rows * cols, costs.size());
+
+        std::vector<int32_t> mates;
+        int64_t total = 0;
+        bool feasible = no_gvl("solve_dense.linear_sum_assignment", [&]() {
+          // solve with the smaller dimension as rows
+          if (rows <= cols) {
+            return solve_dense_assignment(costs, rows, cols, mates, total);
+          }
+
+          std::vector<int64_t> transposed(costs.size());
+          for (int64_t i = 0; i < rows; i++) {
+            for (int64_t j = 0; j < cols; j++) {
+              transposed[j * rows + i] = costs[i * cols + j];
+            }
+          }
+
+          std::vector<int32_t> col_mates;
+          if (!solve_dense_assignment(transposed, cols, rows, col_mates, total)) {
+            return false;
+          }
+          mates.assign(rows, -1);
+          for (int64_t j = 0; j < cols; j++) {
+            mates[col_mates[j]] = j;
+          }
+          return true;
+        });
+
+        Hash result;
+        if (feasible) {
+          Array right_mates(rb_ary_new_capa(mates.size()));
+          for (const auto& mate : mates) {
+            if (mate < 0) {
+              right_mates.push(Object(Qnil), false);
+            } else {
+              right_mates.push(mate, false);
+            }
+          }
+          result[Symbol("status")] = Symbol("optimal");
+          result[Symbol("optimal_cost")] = total;
+          result[Symbol("right_mates")] = right_mates;
         } else {
-          throw std::runtime_error{"Unknown status"};
+          result[Symbol("status")] = Symbol("infeasible");
+          result[Symbol("optimal_cost")] = Object(Qnil);
+          result[Symbol("right_mates")] = Object(Qnil);
+        }
+        return result;
+      })
+    .define_singleton_function(
+      "_solve_batch",
+      [](Array instances, int threads) {
+        std::vector<AssignmentInstance> batch(instances.size());
+        for (size_t i = 0; i < batch.size(); i++) {
+          Array instance(Object(instances[i]));
+          if (instance.size() != 3) {
+            throw std::invalid_argument("Expected instance to be [left_nodes, right_nodes, costs]");
+          }
+
+          auto& b = batch[i];
+          b.left_nodes = read_buffer<int32_t>(Object(instance[0]));
+          b.right_nodes = read_buffer<int32_t>(Object(instance[1]));
+          b.costs = read_buffer<int64_t>(Object(instance[2]));
+          check_sizes(b.left_nodes.size(), b.right_nodes.size());
+          check_sizes(b.left_nodes.size(), b.costs.size());
+          check_assignment_nodes(b.left_nodes);
+          check_assignment_nodes(b.right_nodes);
+        }
+
+        no_gvl("solve_batch.linear_sum_assignment", [&]() {
+          parallel_for(batch.size(), threads, [&](size_t i) {
+            auto& b = batch[i];
+
+            SimpleLinearSumAssignment assignment;
+            for (size_t j = 0; j < b.costs.size(); j++) {
+              assignment.AddArcWithCost(b.left_nodes[j], b.right_nodes[j], b.costs[j]);
+            }
+
+            b.status = assignment.Solve();
+            if (b.status == SimpleLinearSumAssignment::Status::OPTIMAL) {
+              b.optimal_cost = assignment.OptimalCost();
+              b.right_mates.resize(assignment.NumNodes());
+              for (int32_t j = 0; j < assignment.NumNodes(); j++) {
+                b.right_mates[j] = assignment.RightMate(j);
+              }
+            }
+          });
+          return true;
+        });
+
+        Array ret(rb_ary_new_capa(batch.size()));
+        for (const auto& b : batch) {
+          Hash result;
+          result[Symbol("status")] = assignment_status(b.status);
+          if (b.status == SimpleLinearSumAssignment::Status::OPTIMAL) {
+            Array right_mates(rb_ary_new_capa(b.right_mates.size()));
+            for (const auto& mate : b.right_mates) {
+              right_mates.push(mate, false);
+            }
+            result[Symbol("optimal_cost")] = b.optimal_cost;
+            result[Symbol("right_mates")] = right_mates;
+          } else {
+            result[Symbol("optimal_cost")] = Object(Qnil);
+            result[Symbol("right_mates")] = Object(Qnil);
+          }
+          ret.push(result, false);
         }
+        return ret;
       });
 }
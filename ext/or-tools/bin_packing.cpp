@@ -1,53 +1,673 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <ortools/algorithms/knapsack_solver.h>
+#include <ortools/sat/cp_model.h>
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "buffer.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+
 using operations_research::KnapsackSolver;
+using operations_research::sat::BoolVar;
+using operations_research::sat::CpModelBuilder;
+using operations_research::sat::CpSolverResponse;
+using operations_research::sat::CpSolverStatus;
+using operations_research::sat::LinearExpr;
+using operations_research::sat::Model;
+using operations_research::sat::NewSatParameters;
+using operations_research::sat::SatParameters;
+using operations_research::sat::SolutionBooleanValue;
+using operations_research::sat::SolveCpModel;
 
 using Rice::Array;
+using Rice::Hash;
 using Rice::Object;
 using Rice::Symbol;
 
-namespace Rice::detail {
-  template<>
-  struct Type<KnapsackSolver::SolverType> {
-    static bool verify() { return true; }
-  };
+KnapsackSolver::SolverType knapsack_solver_type(const std::string& s) {
+  if (s == "branch_and_bound") {
+    return KnapsackSolver::KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER;
+  } else if (s == "brute_force") {
+    return KnapsackSolver::KNAPSACK_BRUTE_FORCE_SOLVER;
+  } else if (s == "items_64") {
+    return KnapsackSolver::KNAPSACK_64ITEMS_SOLVER;
+  } else if (s == "dynamic_programming") {
+    return KnapsackSolver::KNAPSACK_DYNAMIC_PROGRAMMING_SOLVER;
+  } else if (s == "divide_and_conquer") {
+    return KnapsackSolver::KNAPSACK_DIVIDE_AND_CONQUER_SOLVER;
+  } else if (s == "cbc_mip") {
+    return KnapsackSolver::KNAPSACK_MULTIDIMENSION_CBC_MIP_SOLVER;
+  } else if (s == "scip_mip") {
+    return KnapsackSolver::KNAPSACK_MULTIDIMENSION_SCIP_MIP_SOLVER;
+  } else if (s == "cp_sat") {
+    return KnapsackSolver::KNAPSACK_MULTIDIMENSION_CP_SAT_SOLVER;
+  } else {
+    throw std::runtime_error{"Unknown solver type: " + s};
+  }
+}
+
+Symbol knapsack_solver_type_symbol(KnapsackSolver::SolverType type) {
+  switch (type) {
+    case KnapsackSolver::KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER:
+      return Symbol("branch_and_bound");
+    case KnapsackSolver::KNAPSACK_BRUTE_FORCE_SOLVER:
+      return Symbol("brute_force");
+    case KnapsackSolver::KNAPSACK_64ITEMS_SOLVER:
+      return Symbol("items_64");
+    case KnapsackSolver::KNAPSACK_DYNAMIC_PROGRAMMING_SOLVER:
+      return Symbol("dynamic_programming");
+    case KnapsackSolver::KNAPSACK_DIVIDE_AND_CONQUER_SOLVER:
+      return Symbol("divide_and_conquer");
+    case KnapsackSolver::KNAPSACK_MULTIDIMENSION_CBC_MIP_SOLVER:
+      return Symbol("cbc_mip");
+    case KnapsackSolver::KNAPSACK_MULTIDIMENSION_SCIP_MIP_SOLVER:
+      return Symbol("scip_mip");
+    case KnapsackSolver::KNAPSACK_MULTIDIMENSION_CP_SAT_SOLVER:
+      return Symbol("cp_sat");
+    default:
+      throw std::runtime_error{"Unknown solver type"};
+  }
+}
+
+// thresholds from benchmark/knapsack.rb
+KnapsackSolver::SolverType auto_knapsack_solver_type(const std::vector<int64_t>& values, const std::vector<std::vector<int64_t>>& weights, const std::vector<int64_t>& capacities) {
+  size_t num_items = values.size();
+  if (weights.size() == 1) {
+    if (num_items <= 64) {
+      return KnapsackSolver::KNAPSACK_64ITEMS_SOLVER;
+    }
+    // dynamic programming is O(items * capacity) in time and O(capacity) in memory
+    if (capacities[0] >= 0 && static_cast<double>(num_items) * capacities[0] <= 1e8) {
+      return KnapsackSolver::KNAPSACK_DYNAMIC_PROGRAMMING_SOLVER;
+    }
+    return KnapsackSolver::KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER;
+  }
+  if (num_items <= 100) {
+    return KnapsackSolver::KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER;
+  }
+  return KnapsackSolver::KNAPSACK_MULTIDIMENSION_CP_SAT_SOLVER;
+}
+
+void check_knapsack_problem(KnapsackSolver::SolverType type, const std::vector<int64_t>& values, const std::vector<std::vector<int64_t>>& weights, const std::vector<int64_t>& capacities) {
+  if (weights.size() != capacities.size()) {
+    throw std::invalid_argument("Expected weights and capacities to have the same number of dimensions");
+  }
+  for (const auto& w : weights) {
+    if (w.size() != values.size()) {
+      throw std::invalid_argument("Expected weights and values to have the same number of items");
+    }
+  }
+
+  switch (type) {
+    case KnapsackSolver::KNAPSACK_BRUTE_FORCE_SOLVER:
+    case KnapsackSolver::KNAPSACK_64ITEMS_SOLVER:
+    case KnapsackSolver::KNAPSACK_DYNAMIC_PROGRAMMING_SOLVER:
+    case KnapsackSolver::KNAPSACK_DIVIDE_AND_CONQUER_SOLVER:
+      if (weights.size() != 1) {
+        throw std::invalid_argument("Solver only supports one dimension");
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (type == KnapsackSolver::KNAPSACK_BRUTE_FORCE_SOLVER && values.size() > 30) {
+    throw std::invalid_argument("Solver only supports up to 30 items");
+  }
+  if (type == KnapsackSolver::KNAPSACK_64ITEMS_SOLVER && values.size() > 64) {
+    throw std::invalid_argument("Solver only supports up to 64 items");
+  }
+}
+
+// KnapsackSolver with the solver type chosen at init for :auto
+class Knapsack {
+  public:
+    Knapsack(Symbol type, const std::string& name) : name_(name) {
+      if (type.str() != "auto") {
+        type_ = knapsack_solver_type(type.str());
+      }
+    }
+
+    void init(const std::vector<int64_t>& values, const std::vector<std::vector<int64_t>>& weights, const std::vector<int64_t>& capacities) {
+      auto type = type_ ? *type_ : auto_knapsack_solver_type(values, weights, capacities);
+      check_knapsack_problem(type, values, weights, capacities);
+
+      if (!solver_ || type != solver_type_) {
+        solver_ = std::make_unique<KnapsackSolver>(type, name_);
+        solver_type_ = type;
+        solver_->set_use_reduction(use_reduction_);
+        if (time_limit_) {
+          solver_->set_time_limit(*time_limit_);
+        }
+      }
+      solver_->Init(values, weights, capacities);
+    }
+
+    int64_t solve() {
+      auto& solver = this->solver();
+      return no_gvl("solve.knapsack", [&]() {
+        return solver.Solve();
+      });
+    }
+
+    Array best_solution_items(int num_items) {
+      auto& solver = this->solver();
+      Array ret;
+      for (int i = 0; i < num_items; i++) {
+        if (solver.BestSolutionContains(i)) {
+          ret.push(i, false);
+        }
+      }
+      return ret;
+    }
+
+    bool best_solution_contains(int item_id) {
+      return solver().BestSolutionContains(item_id);
+    }
+
+    bool solution_optimal() {
+      return solver().IsSolutionOptimal();
+    }
+
+    Object solver_type() {
+      if (!solver_) {
+        return Object(Qnil);
+      }
+      return knapsack_solver_type_symbol(solver_type_);
+    }
+
+    void set_time_limit(double time_limit) {
+      time_limit_ = time_limit;
+      if (solver_) {
+        solver_->set_time_limit(time_limit);
+      }
+    }
+
+    void set_use_reduction(bool use_reduction) {
+      use_reduction_ = use_reduction;
+      if (solver_) {
+        solver_->set_use_reduction(use_reduction);
+      }
+    }
+
+    bool use_reduction() {
+      return use_reduction_;
+    }
+
+  private:
+    KnapsackSolver& solver() {
+      if (!solver_) {
+        throw std::runtime_error("Solver not initialized");
+      }
+      return *solver_;
+    }
 
-  template<>
-  class From_Ruby<KnapsackSolver::SolverType> {
+    std::optional<KnapsackSolver::SolverType> type_;
+    std::string name_;
+    std::unique_ptr<KnapsackSolver> solver_;
+    KnapsackSolver::SolverType solver_type_;
+    std::optional<double> time_limit_;
+    bool use_reduction_ = true;
+};
+
+struct KnapsackInstance {
+  std::vector<int64_t> values;
+  std::vector<std::vector<int64_t>> weights;
+  std::vector<int64_t> capacities;
+  KnapsackSolver::SolverType type;
+  int64_t total_value = 0;
+  std::string selection;
+};
+
+// weights are an Array of dimensions or a single buffer with dimensions laid out one after another
+std::vector<std::vector<int64_t>> read_weights(Object weights, size_t num_items, size_t dimensions) {
+  std::vector<std::vector<int64_t>> result;
+  if (weights.is_a(rb_cArray) && Array(weights).size() > 0 && Object(Array(weights)[0]).is_a(rb_cArray)) {
+    Array a(weights);
+    for (size_t i = 0; i < a.size(); i++) {
+      result.push_back(read_buffer<int64_t>(Object(a[i])));
+    }
+  } else {
+    auto flat = read_buffer<int64_t>(weights);
+    check_sizes(num_items * dimensions, flat.size());
+    for (size_t d = 0; d < dimensions; d++) {
+      result.emplace_back(flat.begin() + d * num_items, flat.begin() + (d + 1) * num_items);
+    }
+  }
+  return result;
+}
+
+// Martello-Toth L2 lower bound on the number of bins for one dimension
+int64_t l2_lower_bound(std::vector<int64_t> sizes, int64_t capacity) {
+  std::sort(sizes.begin(), sizes.end(), std::greater<int64_t>());
+  int64_t total = std::accumulate(sizes.begin(), sizes.end(), int64_t{0});
+  int64_t best = (total + capacity - 1) / capacity;
+
+  std::vector<int64_t> ks{0};
+  for (const auto& s : sizes) {
+    if (s <= capacity / 2 && s != ks.back()) {
+      ks.push_back(s);
+    }
+  }
+
+  for (const auto& k : ks) {
+    int64_t n1 = 0;
+    int64_t n2 = 0;
+    int64_t sum2 = 0;
+    int64_t sum3 = 0;
+    for (const auto& s : sizes) {
+      if (s > capacity - k) {
+        n1++;
+      } else if (s > capacity / 2) {
+        n2++;
+        sum2 += s;
+      } else if (s >= k) {
+        sum3 += s;
+      }
+    }
+    int64_t excess = sum3 - (n2 * capacity - sum2);
+    int64_t lb = n1 + n2 + (excess > 0 ? (excess + capacity - 1) / capacity : 0);
+    best = std::max(best, lb);
+  }
+  return best;
+}
+
+// bin packing when values are empty (minimize bins used, every item packed),
+// otherwise multiple knapsack (maximize value of packed items)
+class BinPacker {
   public:
-    From_Ruby() = default;
+    BinPacker(Object sizes, Object capacities, int dimensions, Object values) {
+      if (dimensions < 1) {
+        throw std::invalid_argument("Invalid dimensions");
+      }
+      dimensions_ = dimensions;
+
+      sizes_ = read_buffer<int64_t>(sizes);
+      capacities_ = read_buffer<int64_t>(capacities);
+      if (sizes_.size() % dimensions_ != 0 || capacities_.size() % dimensions_ != 0) {
+        throw std::invalid_argument("Expected sizes and capacities to be a multiple of dimensions");
+      }
+      num_items_ = sizes_.size() / dimensions_;
+      num_bins_ = capacities_.size() / dimensions_;
+
+      if (!values.is_nil()) {
+        values_ = read_buffer<int64_t>(values);
+        check_sizes(num_items_, values_.size());
+      }
+
+      for (const auto& v : sizes_) {
+        if (v < 0) {
+          throw std::invalid_argument("Sizes must be non-negative");
+        }
+      }
+      for (const auto& v : capacities_) {
+        if (v < 0) {
+          throw std::invalid_argument("Capacities must be non-negative");
+        }
+      }
+
+      identical_bins_ = true;
+      for (size_t b = 1; b < num_bins_; b++) {
+        for (size_t d = 0; d < dimensions_; d++) {
+          if (capacity(b, d) != capacity(0, d)) {
+            identical_bins_ = false;
+          }
+        }
+      }
+    }
+
+    Hash solve(double time_limit, int num_workers) {
+      std::vector<int32_t> assignments;
+      CpSolverStatus status;
+      std::optional<int64_t> lower_bound;
 
-    explicit From_Ruby(Arg* arg) : arg_(arg) { }
+      no_gvl("solve.bin_packer", [&]() {
+        status = solve_native(time_limit, num_workers, assignments, lower_bound);
+        return true;
+      });
 
-    double is_convertible(VALUE value) { return Convertible::Exact; }
+      Hash result;
+      if (status == CpSolverStatus::OPTIMAL) {
+        result[Symbol("status")] = Symbol("optimal");
+      } else if (status == CpSolverStatus::FEASIBLE) {
+        result[Symbol("status")] = Symbol("feasible");
+      } else if (status == CpSolverStatus::INFEASIBLE) {
+        result[Symbol("status")] = Symbol("infeasible");
+      } else if (status == CpSolverStatus::MODEL_INVALID) {
+        throw std::runtime_error("Invalid model");
+      } else {
+        result[Symbol("status")] = Symbol("unknown");
+      }
 
-    KnapsackSolver::SolverType convert(VALUE x) {
-      std::string s = Symbol(x).str();
-      if (s == "branch_and_bound") {
-        return KnapsackSolver::KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER;
+      if (assignments.empty() && num_items_ > 0) {
+        result[Symbol("assignments")] = Object(Qnil);
+        result[Symbol("num_bins")] = Object(Qnil);
       } else {
-        throw std::runtime_error{"Unknown solver type: " + s};
+        Array a(rb_ary_new_capa(num_items_));
+        std::vector<bool> used(num_bins_);
+        int64_t total_value = 0;
+        for (size_t i = 0; i < num_items_; i++) {
+          if (assignments[i] < 0) {
+            a.push(Object(Qnil), false);
+          } else {
+            a.push(assignments[i], false);
+            used[assignments[i]] = true;
+            if (!values_.empty()) {
+              total_value += values_[i];
+            }
+          }
+        }
+        result[Symbol("assignments")] = a;
+        result[Symbol("num_bins")] = static_cast<int64_t>(std::count(used.begin(), used.end(), true));
+        if (!values_.empty()) {
+          result[Symbol("total_value")] = total_value;
+        }
+      }
+
+      if (lower_bound) {
+        result[Symbol("lower_bound")] = *lower_bound;
       }
+      return result;
     }
 
   private:
-    Arg* arg_ = nullptr;
-  };
-} // namespace Rice::detail
+    int64_t size(size_t item, size_t d) const {
+      return sizes_[item * dimensions_ + d];
+    }
+
+    int64_t capacity(size_t bin, size_t d) const {
+      return capacities_[bin * dimensions_ + d];
+    }
+
+    bool knapsack() const {
+      return !values_.empty();
+    }
+
+    // items in the order the heuristic packs them, largest (or most valuable
+    // per unit of size for knapsacks) first
+    std::vector<size_t> item_order() const {
+      std::vector<double> max_capacity(dimensions_, 1);
+      for (size_t b = 0; b < num_bins_; b++) {
+        for (size_t d = 0; d < dimensions_; d++) {
+          max_capacity[d] = std::max(max_capacity[d], static_cast<double>(capacity(b, d)));
+        }
+      }
+
+      std::vector<double> keys(num_items_);
+      for (size_t i = 0; i < num_items_; i++) {
+        double normalized = 0;
+        for (size_t d = 0; d < dimensions_; d++) {
+          normalized += size(i, d) / max_capacity[d];
+        }
+        keys[i] = knapsack() ? values_[i] / std::max(normalized, 1e-9) : normalized;
+      }
+
+      std::vector<size_t> order(num_items_);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+      return order;
+    }
+
+    // first fit in the given item order, -1 for items that do not fit
+    std::vector<int32_t> first_fit(const std::vector<size_t>& order) const {
+      std::vector<int32_t> assignments(num_items_, -1);
+      std::vector<int64_t> remaining(capacities_);
+      for (const auto& i : order) {
+        for (size_t b = 0; b < num_bins_; b++) {
+          bool fits = true;
+          for (size_t d = 0; d < dimensions_; d++) {
+            if (size(i, d) > remaining[b * dimensions_ + d]) {
+              fits = false;
+              break;
+            }
+          }
+          if (fits) {
+            for (size_t d = 0; d < dimensions_; d++) {
+              remaining[b * dimensions_ + d] -= size(i, d);
+            }
+            assignments[i] = b;
+            break;
+          }
+        }
+      }
+      return assignments;
+    }
+
+    CpSolverStatus solve_native(double time_limit, int num_workers, std::vector<int32_t>& assignments, std::optional<int64_t>& lower_bound) {
+      auto order = item_order();
+      auto heuristic = first_fit(order);
+      bool heuristic_complete = std::find(heuristic.begin(), heuristic.end(), -1) == heuristic.end();
+
+      size_t num_bins = num_bins_;
+      if (!knapsack()) {
+        for (size_t i = 0; i < num_items_; i++) {
+          for (size_t d = 0; d < dimensions_; d++) {
+            bool fits_any = false;
+            for (size_t b = 0; b < num_bins_; b++) {
+              fits_any = fits_any || size(i, d) <= capacity(b, d);
+            }
+            if (!fits_any) {
+              return CpSolverStatus::INFEASIBLE;
+            }
+          }
+        }
+
+        if (identical_bins_ && num_bins_ > 0) {
+          int64_t lb = 0;
+          for (size_t d = 0; d < dimensions_; d++) {
+            std::vector<int64_t> s(num_items_);
+            for (size_t i = 0; i < num_items_; i++) {
+              s[i] = size(i, d);
+            }
+            if (capacity(0, d) > 0) {
+              lb = std::max(lb, l2_lower_bound(s, capacity(0, d)));
+            }
+          }
+          lower_bound = lb;
+
+          if (static_cast<size_t>(lb) > num_bins_) {
+            return CpSolverStatus::INFEASIBLE;
+          }
+
+          if (heuristic_complete) {
+            // first fit opens bins in order, so only those bins are needed
+            int32_t used = 0;
+            for (const auto& b : heuristic) {
+              used = std::max(used, b + 1);
+            }
+            if (used == lb) {
+              assignments = heuristic;
+              return CpSolverStatus::OPTIMAL;
+            }
+            num_bins = used;
+          }
+        }
+      }
+
+      CpModelBuilder builder;
+      std::vector<std::vector<BoolVar>> x(num_items_, std::vector<BoolVar>(num_bins));
+      std::vector<BoolVar> y(num_bins);
+      for (size_t b = 0; b < num_bins; b++) {
+        y[b] = builder.NewBoolVar();
+      }
+      for (size_t i = 0; i < num_items_; i++) {
+        for (size_t b = 0; b < num_bins; b++) {
+          x[i][b] = builder.NewBoolVar();
+          builder.AddImplication(x[i][b], y[b]);
+        }
+        if (knapsack()) {
+          builder.AddAtMostOne(x[i]);
+        } else {
+          builder.AddExactlyOne(x[i]);
+        }
+      }
+
+      for (size_t b = 0; b < num_bins; b++) {
+        for (size_t d = 0; d < dimensions_; d++) {
+          LinearExpr load;
+          for (size_t i = 0; i < num_items_; i++) {
+            if (size(i, d) > capacity(b, d)) {
+              builder.FixVariable(x[i][b], false);
+            } else if (size(i, d) > 0) {
+              load += LinearExpr::Term(x[i][b], size(i, d));
+            }
+          }
+          builder.AddLessOrEqual(load, LinearExpr::Term(y[b], capacity(b, d)));
+        }
+      }
+
+      if (!knapsack() && identical_bins_) {
+        // symmetry breaking: bins are used in order, and the i-th largest item
+        // goes in one of the first i + 1 bins
+        for (size_t b = 1; b < num_bins; b++) {
+          builder.AddImplication(y[b], y[b - 1]);
+        }
+        for (size_t pos = 0; pos < order.size(); pos++) {
+          for (size_t b = pos + 1; b < num_bins; b++) {
+            builder.FixVariable(x[order[pos]][b], false);
+          }
+        }
+        if (lower_bound) {
+          builder.AddGreaterOrEqual(LinearExpr::Sum(y), *lower_bound);
+        }
+      }
+
+      if (knapsack()) {
+        LinearExpr objective;
+        for (size_t i = 0; i < num_items_; i++) {
+          for (size_t b = 0; b < num_bins; b++) {
+            objective += LinearExpr::Term(x[i][b], values_[i]);
+          }
+        }
+        builder.Maximize(objective);
+      } else {
+        builder.Minimize(LinearExpr::Sum(y));
+      }
+
+      // warm start from first fit
+      if (knapsack() || heuristic_complete) {
+        for (size_t i = 0; i < num_items_; i++) {
+          for (size_t b = 0; b < num_bins; b++) {
+            builder.AddHint(x[i][b], heuristic[i] == static_cast<int32_t>(b));
+          }
+        }
+        for (size_t b = 0; b < num_bins; b++) {
+          builder.AddHint(y[b], std::find(heuristic.begin(), heuristic.end(), static_cast<int32_t>(b)) != heuristic.end());
+        }
+      }
+
+      SatParameters parameters;
+      if (std::isfinite(time_limit)) {
+        parameters.set_max_time_in_seconds(time_limit);
+      }
+      if (num_workers > 0) {
+        parameters.set_num_workers(num_workers);
+      }
+
+      Model model;
+      model.Add(NewSatParameters(parameters));
+      CpSolverResponse response = SolveCpModel(builder.Build(), &model);
+
+      auto status = response.status();
+      if (status == CpSolverStatus::OPTIMAL || status == CpSolverStatus::FEASIBLE) {
+        assignments.assign(num_items_, -1);
+        for (size_t i = 0; i < num_items_; i++) {
+          for (size_t b = 0; b < num_bins; b++) {
+            if (SolutionBooleanValue(response, x[i][b])) {
+              assignments[i] = b;
+            }
+          }
+        }
+      } else if (status == CpSolverStatus::UNKNOWN && (knapsack() || heuristic_complete)) {
+        assignments = heuristic;
+        status = CpSolverStatus::FEASIBLE;
+      }
+      return status;
+    }
+
+    size_t dimensions_;
+    size_t num_items_;
+    size_t num_bins_;
+    std::vector<int64_t> sizes_;
+    std::vector<int64_t> capacities_;
+    std::vector<int64_t> values_;
+    bool identical_bins_;
+};
 
 void init_bin_packing(Rice::Module& m) {
-  Rice::define_class_under<KnapsackSolver>(m, "KnapsackSolver")
-    .define_constructor(Rice::Constructor<KnapsackSolver, KnapsackSolver::SolverType, std::string>())
-    .define_method("_solve", &KnapsackSolver::Solve)
-    .define_method("best_solution_contains?", &KnapsackSolver::BestSolutionContains)
-    .define_method(
-      "init",
-       [](KnapsackSolver& self, const std::vector<int64_t>& values, const std::vector<std::vector<int64_t>>& weights, const std::vector<int64_t>& capacities) {
-        self.Init(values, weights, capacities);
+  Rice::define_class_under<Knapsack>(m, "KnapsackSolver")
+    .define_constructor(Rice::Constructor<Knapsack, Symbol, std::string>())
+    .define_method("_solve", &Knapsack::solve)
+    .define_method("best_solution_contains?", &Knapsack::best_solution_contains)
+    .define_method("solution_optimal?", &Knapsack::solution_optimal)
+    .define_method("solver_type", &Knapsack::solver_type)
+    .define_method("set_time_limit", &Knapsack::set_time_limit)
+    .define_method("set_use_reduction", &Knapsack::set_use_reduction)
+    .define_method("use_reduction", &Knapsack::use_reduction)
+    .define_method("init", &Knapsack::init)
+    .define_method("_best_solution_items", &Knapsack::best_solution_items)
+    .define_singleton_function(
+      "_solve_batch",
+      [](Array instances, Symbol solver_type, int threads) {
+        std::optional<KnapsackSolver::SolverType> type;
+        if (solver_type.str() != "auto") {
+          type = knapsack_solver_type(solver_type.str());
+        }
+
+        std::vector<KnapsackInstance> batch(instances.size());
+        for (size_t i = 0; i < batch.size(); i++) {
+          Array instance(Object(instances[i]));
+          if (instance.size() != 3) {
+            throw std::invalid_argument("Expected instance to be [values, weights, capacities]");
+          }
+
+          auto& b = batch[i];
+          b.values = read_buffer<int64_t>(Object(instance[0]));
+          b.capacities = read_buffer<int64_t>(Object(instance[2]));
+          b.weights = read_weights(Object(instance[1]), b.values.size(), b.capacities.size());
+          b.type = type ? *type : auto_knapsack_solver_type(b.values, b.weights, b.capacities);
+          check_knapsack_problem(b.type, b.values, b.weights, b.capacities);
+        }
+
+        no_gvl("solve_batch.knapsack", [&]() {
+          parallel_for(batch.size(), threads, [&](size_t i) {
+            auto& b = batch[i];
+
+            KnapsackSolver solver(b.type, "KnapsackBatch");
+            solver.Init(b.values, b.weights, b.capacities);
+            b.total_value = solver.Solve();
+
+            // bit i is item i, like String#unpack1("b*")
+            b.selection.assign((b.values.size() + 7) / 8, 0);
+            for (size_t j = 0; j < b.values.size(); j++) {
+              if (solver.BestSolutionContains(j)) {
+                b.selection[j / 8] |= 1 << (j % 8);
+              }
+            }
+          });
+          return true;
+        });
+
+        Array ret(rb_ary_new_capa(batch.size()));
+        for (const auto& b : batch) {
+          Hash result;
+          result[Symbol("total_value")] = b.total_value;
+          result[Symbol("selection")] = Rice::String(rb_str_new(b.selection.data(), b.selection.size()));
+          ret.push(result, false);
+        }
+        return ret;
       });
+
+  Rice::define_class_under<BinPacker>(m, "BinPacker")
+    .define_constructor(Rice::Constructor<BinPacker, Object, Object, int, Object>())
+    .define_method("_solve", &BinPacker::solve);
 }
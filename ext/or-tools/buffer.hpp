@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <rice/rice.hpp>
+#include <rice/stl.hpp>
+
+#include "instrumentation.hpp"
+
+// reads an Array or a packed String in native byte order
+// (Array#pack("l*") for 32-bit values, "q*" for 64-bit values, "d*" for doubles)
+template<typename T>
+std::vector<T> read_buffer(Rice::Object value) {
+  InstrumentedConversion instrumented("buffer");
+  if (value.is_a(rb_cString)) {
+    Rice::String str(value);
+    size_t bytes = RSTRING_LEN(str.value());
+    if (bytes % sizeof(T) != 0) {
+      throw std::invalid_argument("Invalid buffer size");
+    }
+
+    std::vector<T> result(bytes / sizeof(T));
+    std::memcpy(result.data(), RSTRING_PTR(str.value()), bytes);
+    instrumented.finish();
+    return result;
+  }
+
+  auto result = Rice::detail::From_Ruby<std::vector<T>>().convert(value.value());
+  instrumented.finish();
+  return result;
+}
+
+// writes n values from f(i) to a packed String in native byte order
+template<typename T, typename F>
+Rice::String write_buffer(size_t n, F f) {
+  VALUE str = rb_str_new(nullptr, n * sizeof(T));
+  char* ptr = RSTRING_PTR(str);
+  for (size_t i = 0; i < n; i++) {
+    T v = f(i);
+    std::memcpy(ptr + i * sizeof(T), &v, sizeof(T));
+  }
+  return Rice::String(str);
+}
+
+inline void check_sizes(size_t expected, size_t actual) {
+  if (expected != actual) {
+    throw std::invalid_argument("Expected same size, got " + std::to_string(expected) + " and " + std::to_string(actual));
+  }
+}
@@ -5,12 +5,15 @@
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <vector>
 
 template<typename T>
 class Channel {
   std::queue<T> queue;
   std::mutex mutex;
   std::condition_variable cv;
+  std::condition_variable space_cv;
+  bool closed = false;
 
 public:
   void send(T message) {
@@ -19,6 +22,50 @@ public:
     cv.notify_one();
   }
 
+  // never blocks the sender, returns false if the channel is full or closed
+  bool try_send(T message, size_t capacity) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (closed || queue.size() >= capacity) {
+      return false;
+    }
+    queue.push(std::move(message));
+    cv.notify_one();
+    return true;
+  }
+
+  // blocks the sender while the channel is full
+  // returns false without sending if the channel is closed
+  bool send_bounded(T message, size_t capacity) {
+    std::unique_lock<std::mutex> lock(mutex);
+    space_cv.wait(lock, [&] { return closed || queue.size() < capacity; });
+    if (closed) {
+      return false;
+    }
+    queue.push(std::move(message));
+    cv.notify_one();
+    return true;
+  }
+
+  // drops queued messages and wakes blocked senders
+  void close() {
+    std::lock_guard<std::mutex> guard(mutex);
+    closed = true;
+    queue = std::queue<T>();
+    space_cv.notify_all();
+  }
+
+  std::vector<T> drain() {
+    std::lock_guard<std::mutex> guard(mutex);
+    std::vector<T> messages;
+    messages.reserve(queue.size());
+    while (!queue.empty()) {
+      messages.push_back(std::move(queue.front()));
+      queue.pop();
+    }
+    space_cv.notify_all();
+    return messages;
+  }
+
   template<typename U, typename V>
   std::optional<T> recv_timeout(const std::chrono::duration<U, V>& duration) {
     std::unique_lock<std::mutex> lock(mutex);
@@ -27,6 +74,7 @@ public:
     }
     T message = std::move(queue.front());
     queue.pop();
+    space_cv.notify_one();
     return message;
   }
 
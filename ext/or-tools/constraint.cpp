@@ -1,32 +1,71 @@
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <climits>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <google/protobuf/text_format.h>
 #include <ortools/sat/cp_model.h>
+#include <ortools/sat/cp_model_utils.h>
+#include <ortools/util/time_limit.h>
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "buffer.hpp"
 #include "channel.hpp"
+#include "gvl.hpp"
+#include "instrumentation.hpp"
 
 using operations_research::Domain;
+using operations_research::SolverLogger;
+using operations_research::TimeLimit;
+using operations_research::sat::AutomatonConstraint;
 using operations_research::sat::BoolVar;
+using operations_research::sat::CircuitConstraint;
 using operations_research::sat::Constraint;
 using operations_research::sat::CpModelBuilder;
+using operations_research::sat::CpModelProto;
 using operations_research::sat::CpSolverResponse;
+using operations_research::sat::CpSolverResponseStats;
 using operations_research::sat::CpSolverStatus;
+using operations_research::sat::CumulativeConstraint;
+using operations_research::sat::FillDomainInProto;
 using operations_research::sat::IntervalVar;
 using operations_research::sat::IntVar;
 using operations_research::sat::LinearExpr;
 using operations_research::sat::Model;
+using operations_research::sat::MultipleCircuitConstraint;
+using operations_research::sat::NewBestBoundCallback;
 using operations_research::sat::NewFeasibleSolutionObserver;
+using operations_research::sat::NoOverlap2DConstraint;
+using operations_research::sat::ReadDomainFromProto;
+using operations_research::sat::ReservoirConstraint;
 using operations_research::sat::SatParameters;
 using operations_research::sat::SolutionBooleanValue;
 using operations_research::sat::SolutionIntegerValue;
 using operations_research::sat::TableConstraint;
 
+using google::protobuf::FieldDescriptor;
+
 using Rice::Array;
 using Rice::Class;
 using Rice::Object;
@@ -52,6 +91,7 @@ namespace Rice::detail {
     double is_convertible(VALUE value) { return Convertible::Exact; }
 
     LinearExpr convert(VALUE v) {
+      InstrumentedConversion instrumented("LinearExpr");
       LinearExpr expr;
 
       Rice::Object utils = Rice::define_module("ORTools").const_get("Utils");
@@ -70,6 +110,7 @@ namespace Rice::detail {
         }
       }
 
+      instrumented.finish();
       return expr;
     }
 
@@ -78,15 +119,808 @@ namespace Rice::detail {
   };
 } // namespace Rice::detail
 
+const FieldDescriptor* sat_parameters_field(const std::string& name) {
+  auto field = SatParameters::descriptor()->FindFieldByName(name);
+  if (field == nullptr) {
+    throw std::invalid_argument("Unknown parameter: " + name);
+  }
+  return field;
+}
+
+template<typename T>
+Object to_object(const T& value) {
+  return Rice::detail::To_Ruby<T>().convert(value);
+}
+
+// index is ignored for singular fields
+Object sat_parameters_value(const SatParameters& self, const FieldDescriptor* field, int index) {
+  auto reflection = self.GetReflection();
+  bool repeated = field->is_repeated();
+
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return to_object(repeated ? reflection->GetRepeatedBool(self, field, index) : reflection->GetBool(self, field));
+    case FieldDescriptor::CPPTYPE_INT32:
+      return to_object(repeated ? reflection->GetRepeatedInt32(self, field, index) : reflection->GetInt32(self, field));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return to_object(repeated ? reflection->GetRepeatedInt64(self, field, index) : reflection->GetInt64(self, field));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return to_object(repeated ? reflection->GetRepeatedUInt32(self, field, index) : reflection->GetUInt32(self, field));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return to_object(repeated ? reflection->GetRepeatedUInt64(self, field, index) : reflection->GetUInt64(self, field));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return to_object(repeated ? reflection->GetRepeatedDouble(self, field, index) : reflection->GetDouble(self, field));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return to_object(repeated ? reflection->GetRepeatedFloat(self, field, index) : reflection->GetFloat(self, field));
+    case FieldDescriptor::CPPTYPE_STRING:
+      return to_object<std::string>(repeated ? reflection->GetRepeatedString(self, field, index) : reflection->GetString(self, field));
+    case FieldDescriptor::CPPTYPE_ENUM: {
+      auto value = repeated ? reflection->GetRepeatedEnum(self, field, index) : reflection->GetEnum(self, field);
+      std::string name(value->name());
+      std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+      return Symbol(name);
+    }
+    default:
+      throw std::invalid_argument("Unsupported parameter: " + std::string(field->name()));
+  }
+}
+
+void add_sat_parameters_value(SatParameters& self, const FieldDescriptor* field, Object value) {
+  auto reflection = self.GetReflection();
+  bool repeated = field->is_repeated();
+
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_BOOL: {
+      auto v = Rice::detail::From_Ruby<bool>().convert(value.value());
+      repeated ? reflection->AddBool(&self, field, v) : reflection->SetBool(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_INT32: {
+      auto v = Rice::detail::From_Ruby<int32_t>().convert(value.value());
+      repeated ? reflection->AddInt32(&self, field, v) : reflection->SetInt32(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_INT64: {
+      auto v = Rice::detail::From_Ruby<int64_t>().convert(value.value());
+      repeated ? reflection->AddInt64(&self, field, v) : reflection->SetInt64(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_UINT32: {
+      auto v = Rice::detail::From_Ruby<uint32_t>().convert(value.value());
+      repeated ? reflection->AddUInt32(&self, field, v) : reflection->SetUInt32(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_UINT64: {
+      auto v = Rice::detail::From_Ruby<uint64_t>().convert(value.value());
+      repeated ? reflection->AddUInt64(&self, field, v) : reflection->SetUInt64(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_DOUBLE: {
+      auto v = Rice::detail::From_Ruby<double>().convert(value.value());
+      repeated ? reflection->AddDouble(&self, field, v) : reflection->SetDouble(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_FLOAT: {
+      auto v = Rice::detail::From_Ruby<float>().convert(value.value());
+      repeated ? reflection->AddFloat(&self, field, v) : reflection->SetFloat(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_STRING: {
+      auto v = Rice::detail::From_Ruby<std::string>().convert(value.to_s().value());
+      repeated ? reflection->AddString(&self, field, v) : reflection->SetString(&self, field, v);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_ENUM: {
+      // enum values are upper case in protobuf and lower case symbols in Ruby
+      std::string name = value.to_s().str();
+      std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+      auto v = field->enum_type()->FindValueByName(name);
+      if (v == nullptr) {
+        throw std::invalid_argument("Unknown value for " + std::string(field->name()) + ": " + value.to_s().str());
+      }
+      repeated ? reflection->AddEnum(&self, field, v) : reflection->SetEnum(&self, field, v);
+      break;
+    }
+    default:
+      throw std::invalid_argument("Unsupported parameter: " + std::string(field->name()));
+  }
+}
+
+void parse_model(const char* data, size_t size, bool text, CpModelProto* proto) {
+  bool success;
+  if (text) {
+    success = google::protobuf::TextFormat::ParseFromString(std::string(data, size), proto);
+  } else if (size > INT_MAX) {
+    success = false;
+  } else {
+    success = proto->ParseFromArray(data, static_cast<int>(size));
+  }
+  if (!success) {
+    throw std::invalid_argument("Invalid model");
+  }
+}
+
+// same text extensions as ExportToFile, everything else is binary
+bool text_model_file(const std::string& path) {
+  for (const std::string ext : {"txt", "textproto"}) {
+    if (path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// raises Errno::* like File.read
+[[noreturn]] void model_file_error(int err, const std::string& path) {
+  Rice::detail::protect([&]() {
+    rb_syserr_fail(err, path.c_str());
+    return Qnil;
+  });
+  throw std::runtime_error("unreachable");
+}
+
+// maps the file instead of reading it into a string
+void load_model_file(const std::string& path, CpModelProto* proto) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    model_file_error(errno, path);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    int err = errno;
+    close(fd);
+    model_file_error(err, path);
+  }
+
+  size_t size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    return;
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int err = errno;
+  close(fd);
+  if (data == MAP_FAILED) {
+    model_file_error(err, path);
+  }
+
+  try {
+    parse_model(static_cast<const char*>(data), size, text_model_file(path), proto);
+  } catch (...) {
+    munmap(data, size);
+    throw;
+  }
+  munmap(data, size);
+}
+
+CpModelBuilder import_model(const CpModelProto& proto) {
+  CpModelBuilder builder;
+  builder.ResetAndImport(proto);
+  return builder;
+}
+
+int model_variable_index(const CpModelBuilder& self, int index) {
+  if (index < 0 || index >= self.Proto().variables_size()) {
+    throw std::out_of_range("Index out of range");
+  }
+  return index;
+}
+
+// updated from solver threads, so it can be read from Ruby during a solve
+class SearchProgress {
+  public:
+    struct Subsolver {
+      int64_t num_solutions = 0;
+      double objective = 0;
+      double last_solution_time = 0;
+    };
+
+    void reset() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      start_ = std::chrono::steady_clock::now();
+      num_solutions_ = 0;
+      best_bound_.reset();
+      objective_.reset();
+      first_solution_time_.reset();
+      last_solution_time_.reset();
+      dropped_log_messages_ = 0;
+      subsolvers_.clear();
+      stop_reason_.reset();
+    }
+
+    void add_solution(const CpSolverResponse& response) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      double time = elapsed();
+      num_solutions_++;
+      objective_ = response.objective_value();
+      if (!first_solution_time_.has_value()) {
+        first_solution_time_ = time;
+      }
+      last_solution_time_ = time;
+
+      // solution info starts with the name of the subsolver that found it
+      const std::string& info = response.solution_info();
+      std::string name = info.substr(0, info.find_first_of(" ("));
+      auto& subsolver = subsolvers_[name.empty() ? "unknown" : name];
+      subsolver.num_solutions++;
+      subsolver.objective = response.objective_value();
+      subsolver.last_solution_time = time;
+    }
+
+    void set_best_bound(double bound) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      best_bound_ = bound;
+    }
+
+    void add_dropped_log_message() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      dropped_log_messages_++;
+    }
+
+    // keeps the first reason
+    void set_stop_reason(const std::string& reason) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!stop_reason_.has_value()) {
+        stop_reason_ = reason;
+      }
+    }
+
+    Object stop_reason() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      return stop_reason_symbol();
+    }
+
+    Rice::Hash to_hash() {
+      std::lock_guard<std::mutex> guard(mutex_);
+
+      Rice::Hash subsolvers;
+      for (const auto& [name, subsolver] : subsolvers_) {
+        Rice::Hash h;
+        h[Symbol("num_solutions")] = subsolver.num_solutions;
+        h[Symbol("objective")] = subsolver.objective;
+        h[Symbol("last_solution_time")] = subsolver.last_solution_time;
+        subsolvers[name] = h;
+      }
+
+      Rice::Hash result;
+      result[Symbol("num_solutions")] = num_solutions_;
+      result[Symbol("objective")] = optional_value(objective_);
+      result[Symbol("best_bound")] = optional_value(best_bound_);
+      result[Symbol("first_solution_time")] = optional_value(first_solution_time_);
+      result[Symbol("last_solution_time")] = optional_value(last_solution_time_);
+      result[Symbol("dropped_log_messages")] = dropped_log_messages_;
+      result[Symbol("stop_reason")] = stop_reason_symbol();
+      result[Symbol("subsolvers")] = subsolvers;
+      return result;
+    }
+
+  private:
+    double elapsed() {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    static Object optional_value(const std::optional<double>& value) {
+      return value.has_value() ? to_object(value.value()) : Object(Qnil);
+    }
+
+    Object stop_reason_symbol() {
+      return stop_reason_.has_value() ? Object(Symbol(stop_reason_.value())) : Object(Qnil);
+    }
+
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    int64_t num_solutions_ = 0;
+    std::optional<double> objective_;
+    std::optional<double> best_bound_;
+    std::optional<double> first_solution_time_;
+    std::optional<double> last_solution_time_;
+    uint64_t dropped_log_messages_ = 0;
+    std::map<std::string, Subsolver> subsolvers_;
+    std::optional<std::string> stop_reason_;
+};
+
+// stopping rules evaluated on solver threads when the incumbent or bound improves
+// NAN disables a rule, and no improvement is checked by a watchdog thread
+class StopRules {
+  public:
+    StopRules(Model* model, SearchProgress* progress, bool maximize, double relative_gap, double absolute_gap, double no_improvement_time, double target_objective)
+      : model_(model), progress_(progress), maximize_(maximize), relative_gap_(relative_gap), absolute_gap_(absolute_gap), no_improvement_time_(no_improvement_time), target_objective_(target_objective) { }
+
+    ~StopRules() {
+      finish();
+    }
+
+    bool active() const {
+      return !std::isnan(relative_gap_) || !std::isnan(absolute_gap_) || !std::isnan(no_improvement_time_) || !std::isnan(target_objective_);
+    }
+
+    void start() {
+      last_improvement_ = std::chrono::steady_clock::now();
+      if (!std::isnan(no_improvement_time_)) {
+        watchdog_ = std::thread([this]() { watch(); });
+      }
+    }
+
+    void finish() {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        finished_ = true;
+      }
+      cv_.notify_all();
+      if (watchdog_.joinable()) {
+        watchdog_.join();
+      }
+    }
+
+    void on_solution(double objective, double bound) {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        objective_ = objective;
+        update_bound(bound);
+        last_improvement_ = std::chrono::steady_clock::now();
+      }
+      cv_.notify_all();
+
+      if (!std::isnan(target_objective_) && (maximize_ ? objective >= target_objective_ : objective <= target_objective_)) {
+        stop("target_objective");
+      }
+      check_gap();
+    }
+
+    void on_bound(double bound) {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        update_bound(bound);
+      }
+      check_gap();
+    }
+
+  private:
+    // bounds only improve, but callbacks from different threads can arrive out of order
+    void update_bound(double bound) {
+      if (!bound_.has_value() || (maximize_ ? bound < bound_.value() : bound > bound_.value())) {
+        bound_ = bound;
+      }
+    }
+
+    void check_gap() {
+      double gap;
+      double objective;
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!objective_.has_value() || !bound_.has_value()) {
+          return;
+        }
+        objective = objective_.value();
+        gap = std::abs(objective - bound_.value());
+      }
+
+      if (!std::isnan(absolute_gap_) && gap <= absolute_gap_) {
+        stop("absolute_gap");
+      } else if (!std::isnan(relative_gap_) && gap / std::max(1.0, std::abs(objective)) <= relative_gap_) {
+        stop("relative_gap");
+      }
+    }
+
+    void watch() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(no_improvement_time_));
+      while (!finished_) {
+        auto deadline = last_improvement_ + window;
+        if (std::chrono::steady_clock::now() >= deadline) {
+          lock.unlock();
+          stop("no_improvement");
+          return;
+        }
+        cv_.wait_until(lock, deadline);
+      }
+    }
+
+    void stop(const char* reason) {
+      if (!stopped_.exchange(true)) {
+        progress_->set_stop_reason(reason);
+        StopSearch(model_);
+      }
+    }
+
+    Model* model_;
+    SearchProgress* progress_;
+    bool maximize_;
+    double relative_gap_;
+    double absolute_gap_;
+    double no_improvement_time_;
+    double target_objective_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::optional<double> objective_;
+    std::optional<double> bound_;
+    std::chrono::steady_clock::time_point last_improvement_;
+    bool finished_ = false;
+    std::atomic<bool> stopped_ = false;
+    std::thread watchdog_;
+};
+
+// records the values of some variables for each solution into a packed buffer
+// filled on solver threads without calling Ruby
+class SolutionPool {
+  public:
+    SolutionPool(Array vars, int64_t limit, bool unique) : limit_(limit), unique_(unique) {
+      refs_.reserve(vars.size());
+      for (const auto& v : vars) {
+        Object var(v);
+        if (var.is_a(rb_cBoolVar)) {
+          refs_.push_back(Rice::detail::From_Ruby<BoolVar>().convert(var.value()).index());
+        } else {
+          refs_.push_back(Rice::detail::From_Ruby<IntVar>().convert(var.value()).index());
+        }
+      }
+    }
+
+    // returns false once the limit is reached
+    bool add(const CpSolverResponse& response) {
+      std::vector<int64_t> row(refs_.size());
+      for (size_t i = 0; i < refs_.size(); i++) {
+        int ref = refs_[i];
+        // negative refs are negated Boolean variables
+        row[i] = ref >= 0 ? response.solution(ref) : 1 - response.solution(-ref - 1);
+      }
+
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (full()) {
+        return false;
+      }
+      if (unique_ && !seen_.emplace(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(int64_t)).second) {
+        return true;
+      }
+      values_.insert(values_.end(), row.begin(), row.end());
+      num_solutions_++;
+      return !full();
+    }
+
+    void check_model(const CpModelBuilder& model) const {
+      for (int ref : refs_) {
+        if ((ref >= 0 ? ref : -ref - 1) >= model.Proto().variables_size()) {
+          throw std::invalid_argument("Variable not in model");
+        }
+      }
+    }
+
+    size_t num_vars() const {
+      return refs_.size();
+    }
+
+    size_t size() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      return rows();
+    }
+
+    int64_t num_solutions() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      return num_solutions_;
+    }
+
+    Array to_a() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      return rows_to_a(rows());
+    }
+
+    String to_binary() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      return write_buffer<int64_t>(values_.size(), [&](size_t i) { return values_[i]; });
+    }
+
+    // removes and returns up to max_rows solutions, so a pool can be read in chunks
+    Array shift(size_t max_rows) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      size_t n = std::min(max_rows, rows());
+      Array ret = rows_to_a(n);
+      values_.erase(values_.begin(), values_.begin() + n * refs_.size());
+      return ret;
+    }
+
+    void clear() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      values_.clear();
+      seen_.clear();
+      num_solutions_ = 0;
+    }
+
+  private:
+    bool full() const {
+      return limit_ > 0 && num_solutions_ >= limit_;
+    }
+
+    size_t rows() const {
+      return refs_.empty() ? 0 : values_.size() / refs_.size();
+    }
+
+    Array rows_to_a(size_t n) const {
+      Array ret(rb_ary_new_capa(n));
+      for (size_t r = 0; r < n; r++) {
+        Array row(rb_ary_new_capa(refs_.size()));
+        for (size_t i = 0; i < refs_.size(); i++) {
+          row.push(values_[r * refs_.size() + i], false);
+        }
+        ret.push(row, false);
+      }
+      return ret;
+    }
+
+    std::vector<int> refs_;
+    int64_t limit_;
+    bool unique_;
+    std::mutex mutex_;
+    std::vector<int64_t> values_;
+    std::unordered_set<std::string> seen_;
+    int64_t num_solutions_ = 0;
+};
+
+// log lines are dropped instead of blocking the solver if Ruby falls behind
+const size_t kMaxLogMessages = 10000;
+
+// solutions are never dropped, so the solver waits for the callback instead
+// (like a synchronous callback) once this many are queued
+const size_t kMaxQueuedSolutions = 100;
+
+// stops and joins worker threads on every path (errors, interrupts, and
+// exceptions from the block), since they use locals from the calling frame
+class WorkerPoolGuard {
+  public:
+    WorkerPoolGuard(std::atomic<bool>& stopped, std::vector<std::thread>& pool) : stopped_(stopped), pool_(pool) {}
+
+    WorkerPoolGuard(const WorkerPoolGuard&) = delete;
+    WorkerPoolGuard& operator=(const WorkerPoolGuard&) = delete;
+
+    ~WorkerPoolGuard() {
+      stopped_ = true;
+      join();
+    }
+
+    // never raises, so it is safe to call while unwinding
+    void join() {
+      auto join_all = [&]() {
+        for (auto& thread : pool_) {
+          if (thread.joinable()) {
+            thread.join();
+          }
+        }
+      };
+
+      // the callback is skipped if an interrupt is pending,
+      // in which case join with the GVL held
+      rb_nogvl(
+        [](void* arg) -> void* {
+          (*static_cast<decltype(join_all)*>(arg))();
+          return nullptr;
+        },
+        &join_all,
+        nullptr,
+        nullptr,
+        RB_NOGVL_INTR_FAIL
+      );
+      join_all();
+    }
+
+  private:
+    std::atomic<bool>& stopped_;
+    std::vector<std::thread>& pool_;
+};
+
+// solves models on native threads that share a budget of total_threads workers
+// larger models start first, and each model gets an equal share of the free
+// threads when it starts, so the budget is never oversubscribed
+// workers read the model protos directly, so they must not be modified
+// until this returns (including from the block)
+Array solve_many(Array models, const SatParameters& parameters, int total_threads, double time_limit, Object block) {
+  std::vector<const CpModelProto*> protos;
+  protos.reserve(models.size());
+  for (const auto& v : models) {
+    protos.push_back(&Rice::detail::From_Ruby<CpModelBuilder*>().convert(v.value())->Proto());
+  }
+
+  size_t n = protos.size();
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return protos[a]->variables_size() + protos[a]->constraints_size() > protos[b]->variables_size() + protos[b]->constraints_size();
+  });
+
+  int budget = total_threads > 0 ? total_threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  size_t slots = std::min<size_t>(n, budget);
+
+  std::atomic<bool> stopped = false;
+  std::mutex mutex;
+  size_t next = 0;
+  size_t running = 0;
+  int used = 0;
+  std::exception_ptr error;
+  std::atomic<size_t> finished_threads = 0;
+  Channel<std::pair<size_t, CpSolverResponse>> channel;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t i;
+      int workers;
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (next == n || stopped) {
+          break;
+        }
+        size_t waiting = std::min(n - next, slots - running);
+        i = order[next++];
+        workers = std::max(1, (budget - used) / static_cast<int>(waiting));
+        used += workers;
+        running++;
+      }
+
+      try {
+        SatParameters model_parameters = parameters;
+        model_parameters.set_num_workers(workers);
+        if (std::isfinite(time_limit)) {
+          model_parameters.set_max_time_in_seconds(std::min(model_parameters.max_time_in_seconds(), time_limit));
+        }
+
+        Model m;
+        m.Add(NewSatParameters(model_parameters));
+        m.GetOrCreate<TimeLimit>()->RegisterExternalBooleanAsLimit(&stopped);
+        channel.send({i, SolveCpModel(*protos[i], &m)});
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        stopped = true;
+      }
+
+      std::lock_guard<std::mutex> guard(mutex);
+      used -= workers;
+      running--;
+    }
+    finished_threads++;
+  };
+
+  InstrumentedPhase instrumented("solve_many.cp_sat");
+
+  std::vector<std::thread> pool;
+  WorkerPoolGuard pool_guard(stopped, pool);
+  for (size_t t = 0; t < slots; t++) {
+    pool.emplace_back(worker);
+  }
+
+  // on exceptions and interrupts, the guard stops the other models
+  std::vector<std::optional<CpSolverResponse>> responses(n);
+  size_t received = 0;
+  while (received < n) {
+    auto message = no_gvl_interruptible(
+      [&]() {
+        return channel.recv_timeout(std::chrono::milliseconds(10));
+      },
+      []() {}
+    );
+
+    if (!message) {
+      if (finished_threads == pool.size() && channel.empty()) {
+        break;
+      }
+      Rice::detail::protect(rb_thread_check_ints);
+      continue;
+    }
+
+    received++;
+    auto& [i, response] = message.value();
+    if (!block.is_nil()) {
+      block.call("call", i, response);
+    }
+    responses[i] = std::move(response);
+  }
+  pool_guard.join();
+  instrumented.finish(true);
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  Array ret(rb_ary_new_capa(n));
+  for (auto& response : responses) {
+    if (response.has_value()) {
+      ret.push(response.value(), false);
+    } else {
+      ret.push(Object(Qnil), false);
+    }
+  }
+  return ret;
+}
+
+// also accepts an IntVar with a Boolean domain
+BoolVar to_bool_var(Object literal) {
+  if (literal.is_a(rb_cSatIntVar)) {
+    return Rice::detail::From_Ruby<IntVar>().convert(literal.value()).ToBoolVar();
+  }
+  return Rice::detail::From_Ruby<BoolVar>().convert(literal.value());
+}
+
+std::vector<BoolVar> to_bool_vars(Array literals) {
+  std::vector<BoolVar> vec;
+  vec.reserve(literals.size());
+  for (const auto& v : literals) {
+    vec.push_back(to_bool_var(Object(v)));
+  }
+  return vec;
+}
+
+// arcs are [tail, head, literal]
+template<typename T>
+void add_circuit_arcs(T& constraint, Array arcs) {
+  for (const auto& v : arcs) {
+    Array arc(Object(v));
+    if (arc.size() != 3) {
+      throw std::invalid_argument("Expected arcs to be [tail, head, literal]");
+    }
+    auto tail = Rice::detail::From_Ruby<int>().convert(arc[0].value());
+    auto head = Rice::detail::From_Ruby<int>().convert(arc[1].value());
+    constraint.AddArc(tail, head, to_bool_var(arc[2]));
+  }
+}
+
 void init_constraint(Rice::Module& m) {
   Rice::define_class_under<Domain>(m, "Domain")
     .define_constructor(Rice::Constructor<Domain, int64_t, int64_t>())
     .define_singleton_function("from_values", &Domain::FromValues)
+    .define_singleton_function(
+      "from_intervals",
+      [](const std::vector<std::vector<int64_t>>& intervals) {
+        for (const auto& interval : intervals) {
+          if (interval.size() != 1 && interval.size() != 2) {
+            throw std::invalid_argument("Expected intervals to be [min, max] or [value]");
+          }
+        }
+        return Domain::FromVectorIntervals(intervals);
+      })
+    .define_singleton_function(
+      "from_flat_intervals",
+      [](const std::vector<int64_t>& flat_intervals) {
+        if (flat_intervals.size() % 2 != 0) {
+          throw std::invalid_argument("Expected an even number of values");
+        }
+        return Domain::FromFlatIntervals(flat_intervals);
+      })
+    .define_singleton_function("all_values", &Domain::AllValues)
+    .define_singleton_function("greater_or_equal", &Domain::GreaterOrEqual)
+    .define_singleton_function("lower_or_equal", &Domain::LowerOrEqual)
     .define_method("min", &Domain::Min)
-    .define_method("max", &Domain::Max);
+    .define_method("max", &Domain::Max)
+    .define_method("size", &Domain::Size)
+    .define_method("empty?", &Domain::IsEmpty)
+    .define_method("fixed?", &Domain::IsFixed)
+    .define_method("contains?", &Domain::Contains)
+    .define_method("included_in?", &Domain::IsIncludedIn)
+    .define_method("flattened_intervals", &Domain::FlattenedIntervals)
+    .define_method("complement", &Domain::Complement)
+    .define_method("negation", &Domain::Negation)
+    .define_method("union_with", &Domain::UnionWith)
+    .define_method("intersection_with", &Domain::IntersectionWith)
+    .define_method("addition_with", &Domain::AdditionWith)
+    .define_method(
+      "==",
+      [](const Domain& self, Object other) {
+        if (!other.is_a(Rice::Data_Type<Domain>::klass())) {
+          return false;
+        }
+        return self == Rice::detail::From_Ruby<Domain>().convert(other.value());
+      })
+    .define_method("to_s", &Domain::ToString)
+    .define_method(
+      "inspect",
+      [](const Domain& self) {
+        return "#<ORTools::Domain " + self.ToString() + ">";
+      });
 
   rb_cSatIntVar = Rice::define_class_under<IntVar>(m, "SatIntVar")
     .define_method("name", &IntVar::Name)
+    .define_method("index", &IntVar::index)
     .define_method("domain", &IntVar::Domain);
 
   Rice::define_class_under<IntervalVar>(m, "SatIntervalVar")
@@ -96,23 +930,11 @@ void init_constraint(Rice::Module& m) {
     .define_method(
       "only_enforce_if",
       [](Constraint& self, Object literal) {
-        if (literal.is_a(rb_cSatIntVar)) {
-          return self.OnlyEnforceIf(Rice::detail::From_Ruby<IntVar>().convert(literal).ToBoolVar());
-        } else if (literal.is_a(rb_cArray)) {
+        if (literal.is_a(rb_cArray)) {
           // TODO support IntVarSpan
-          auto a = Array(literal);
-          std::vector<BoolVar> vec;
-          vec.reserve(a.size());
-          for (const auto& v : a) {
-            if (Object(v).is_a(rb_cSatIntVar)) {
-              vec.push_back(Rice::detail::From_Ruby<IntVar>().convert(v.value()).ToBoolVar());
-            } else {
-              vec.push_back(Rice::detail::From_Ruby<BoolVar>().convert(v.value()));
-            }
-          }
-          return self.OnlyEnforceIf(vec);
+          return self.OnlyEnforceIf(to_bool_vars(Array(literal)));
         } else {
-          return self.OnlyEnforceIf(Rice::detail::From_Ruby<BoolVar>().convert(literal));
+          return self.OnlyEnforceIf(to_bool_var(literal));
         }
       });
 
@@ -147,7 +969,85 @@ void init_constraint(Rice::Module& m) {
     .define_method("num_workers", &SatParameters::num_workers)
     .define_method("num_workers=", &SatParameters::set_num_workers)
     .define_method("random_seed", &SatParameters::random_seed)
-    .define_method("random_seed=", &SatParameters::set_random_seed);
+    .define_method("random_seed=", &SatParameters::set_random_seed)
+    .define_method("max_deterministic_time", &SatParameters::max_deterministic_time)
+    .define_method("max_deterministic_time=", &SatParameters::set_max_deterministic_time)
+    .define_method("relative_gap_limit", &SatParameters::relative_gap_limit)
+    .define_method("relative_gap_limit=", &SatParameters::set_relative_gap_limit)
+    .define_method("absolute_gap_limit", &SatParameters::absolute_gap_limit)
+    .define_method("absolute_gap_limit=", &SatParameters::set_absolute_gap_limit)
+    .define_method("symmetry_level", &SatParameters::symmetry_level)
+    .define_method("symmetry_level=", &SatParameters::set_symmetry_level)
+    .define_method("interleave_search", &SatParameters::interleave_search)
+    .define_method("interleave_search=", &SatParameters::set_interleave_search)
+    .define_method("log_search_progress", &SatParameters::log_search_progress)
+    .define_method("log_search_progress=", &SatParameters::set_log_search_progress)
+    .define_method("max_memory_in_mb", &SatParameters::max_memory_in_mb)
+    .define_method("max_memory_in_mb=", &SatParameters::set_max_memory_in_mb)
+    .define_method("fix_variables_to_their_hinted_value", &SatParameters::fix_variables_to_their_hinted_value)
+    .define_method("fix_variables_to_their_hinted_value=", &SatParameters::set_fix_variables_to_their_hinted_value)
+    // any other parameter by name, using protobuf reflection
+    .define_method(
+      "[]",
+      [](SatParameters& self, const std::string& name) -> Object {
+        auto field = sat_parameters_field(name);
+        if (!field->is_repeated()) {
+          return sat_parameters_value(self, field, 0);
+        }
+
+        int size = self.GetReflection()->FieldSize(self, field);
+        Array ret(rb_ary_new_capa(size));
+        for (int i = 0; i < size; i++) {
+          ret.push(sat_parameters_value(self, field, i), false);
+        }
+        return ret;
+      })
+    .define_method(
+      "[]=",
+      [](SatParameters& self, const std::string& name, Object value) {
+        auto field = sat_parameters_field(name);
+        if (value.is_nil()) {
+          self.GetReflection()->ClearField(&self, field);
+        } else if (field->is_repeated()) {
+          // convert every element first, so an invalid one leaves the field unchanged
+          SatParameters values;
+          for (const auto& v : Array(value)) {
+            add_sat_parameters_value(values, field, Object(v));
+          }
+          self.GetReflection()->SwapFields(&self, &values, {field});
+        } else {
+          add_sat_parameters_value(self, field, value);
+        }
+      })
+    .define_method(
+      "merge_text",
+      [](SatParameters& self, const std::string& text) {
+        if (!google::protobuf::TextFormat::MergeFromString(text, &self)) {
+          throw std::invalid_argument("Invalid parameters");
+        }
+      })
+    .define_method(
+      "merge_binary",
+      [](SatParameters& self, const std::string& data) {
+        if (!self.MergeFromString(data)) {
+          throw std::invalid_argument("Invalid parameters");
+        }
+      })
+    .define_method(
+      "to_text",
+      [](SatParameters& self) {
+        std::string text;
+        if (!google::protobuf::TextFormat::PrintToString(self, &text)) {
+          throw std::runtime_error("PrintToString failed");
+        }
+        return text;
+      })
+    .define_method(
+      "to_binary",
+      [](SatParameters& self) {
+        std::string data = self.SerializeAsString();
+        return String(rb_str_new(data.data(), data.size()));
+      });
 
   Rice::define_class_under<CpModelBuilder>(m, "CpModel")
     .define_constructor(Rice::Constructor<CpModelBuilder>())
@@ -157,6 +1057,14 @@ void init_constraint(Rice::Module& m) {
         const operations_research::Domain domain(start, end);
         return self.NewIntVar(domain).WithName(name);
       })
+    .define_method(
+      "new_int_var_from_domain",
+      [](CpModelBuilder& self, const Domain& domain, const std::string& name) {
+        if (domain.IsEmpty()) {
+          throw std::invalid_argument("Empty domain");
+        }
+        return self.NewIntVar(domain).WithName(name);
+      })
     .define_method(
       "new_bool_var",
       [](CpModelBuilder& self, const std::string& name) {
@@ -179,13 +1087,23 @@ void init_constraint(Rice::Module& m) {
       })
     .define_method(
       "new_interval_var",
-      [](CpModelBuilder& self, const IntVar& start, const IntVar& size, const IntVar& end, const std::string& name) {
+      [](CpModelBuilder& self, LinearExpr start, LinearExpr size, LinearExpr end, const std::string& name) {
         return self.NewIntervalVar(start, size, end).WithName(name);
       })
+    .define_method(
+      "new_fixed_size_interval_var",
+      [](CpModelBuilder& self, LinearExpr start, int64_t size, const std::string& name) {
+        return self.NewFixedSizeIntervalVar(start, size).WithName(name);
+      })
     .define_method(
       "new_optional_interval_var",
-      [](CpModelBuilder& self, const IntVar& start, const IntVar& size, const IntVar& end, const BoolVar& presence, const std::string& name) {
-        return self.NewOptionalIntervalVar(start, size, end, presence).WithName(name);
+      [](CpModelBuilder& self, LinearExpr start, LinearExpr size, LinearExpr end, Object presence, const std::string& name) {
+        return self.NewOptionalIntervalVar(start, size, end, to_bool_var(presence)).WithName(name);
+      })
+    .define_method(
+      "new_optional_fixed_size_interval_var",
+      [](CpModelBuilder& self, LinearExpr start, int64_t size, Object presence, const std::string& name) {
+        return self.NewOptionalFixedSizeIntervalVar(start, size, to_bool_var(presence)).WithName(name);
       })
     .define_method(
       "add_bool_or",
@@ -202,6 +1120,21 @@ void init_constraint(Rice::Module& m) {
       [](CpModelBuilder& self, const std::vector<BoolVar>& literals) {
         return self.AddBoolXor(literals);
       })
+    .define_method(
+      "add_at_least_one",
+      [](CpModelBuilder& self, Array literals) {
+        return self.AddAtLeastOne(to_bool_vars(literals));
+      })
+    .define_method(
+      "add_at_most_one",
+      [](CpModelBuilder& self, Array literals) {
+        return self.AddAtMostOne(to_bool_vars(literals));
+      })
+    .define_method(
+      "add_exactly_one",
+      [](CpModelBuilder& self, Array literals) {
+        return self.AddExactlyOne(to_bool_vars(literals));
+      })
     .define_method(
       "add_implication",
       [](CpModelBuilder& self, const BoolVar& a, const BoolVar& b) {
@@ -238,9 +1171,15 @@ void init_constraint(Rice::Module& m) {
         return self.AddLinearConstraint(expr, Domain(lb, ub));
       })
     .define_method(
-      "add_linear_expression_in_domain",
-      [](CpModelBuilder& self, LinearExpr expr, const Domain& domain) {
-        return self.AddLinearConstraint(expr, domain);
+      "_add_linear_expression_in_domain",
+      [](CpModelBuilder& self, LinearExpr expr, const Domain& domain, Object enforcement_literals) {
+        Constraint constraint = self.AddLinearConstraint(expr, domain);
+        if (enforcement_literals.is_a(rb_cArray)) {
+          constraint.OnlyEnforceIf(to_bool_vars(Array(enforcement_literals)));
+        } else if (!enforcement_literals.is_nil()) {
+          constraint.OnlyEnforceIf(to_bool_var(enforcement_literals));
+        }
+        return constraint;
       })
     .define_method(
       "add_not_equal",
@@ -302,6 +1241,79 @@ void init_constraint(Rice::Module& m) {
       [](CpModelBuilder& self, const std::vector<IntervalVar>& vars) {
         return self.AddNoOverlap(vars);
       })
+    .define_method(
+      "add_no_overlap_2d",
+      [](CpModelBuilder& self, const std::vector<IntervalVar>& x_intervals, const std::vector<IntervalVar>& y_intervals) {
+        check_sizes(x_intervals.size(), y_intervals.size());
+        NoOverlap2DConstraint constraint = self.AddNoOverlap2D();
+        for (size_t i = 0; i < x_intervals.size(); i++) {
+          constraint.AddRectangle(x_intervals[i], y_intervals[i]);
+        }
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_cumulative",
+      [](CpModelBuilder& self, const std::vector<IntervalVar>& intervals, std::vector<LinearExpr> demands, LinearExpr capacity) {
+        check_sizes(intervals.size(), demands.size());
+        CumulativeConstraint constraint = self.AddCumulative(capacity);
+        for (size_t i = 0; i < intervals.size(); i++) {
+          constraint.AddDemand(intervals[i], demands[i]);
+        }
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_circuit",
+      [](CpModelBuilder& self, Array arcs) {
+        CircuitConstraint constraint = self.AddCircuitConstraint();
+        add_circuit_arcs(constraint, arcs);
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_multiple_circuit",
+      [](CpModelBuilder& self, Array arcs) {
+        MultipleCircuitConstraint constraint = self.AddMultipleCircuitConstraint();
+        add_circuit_arcs(constraint, arcs);
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_reservoir_constraint",
+      [](CpModelBuilder& self, std::vector<LinearExpr> times, const std::vector<int64_t>& level_changes, int64_t min_level, int64_t max_level) {
+        check_sizes(times.size(), level_changes.size());
+        ReservoirConstraint constraint = self.AddReservoirConstraint(min_level, max_level);
+        for (size_t i = 0; i < times.size(); i++) {
+          constraint.AddEvent(times[i], level_changes[i]);
+        }
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_reservoir_constraint_with_active",
+      [](CpModelBuilder& self, std::vector<LinearExpr> times, const std::vector<int64_t>& level_changes, Array actives, int64_t min_level, int64_t max_level) {
+        auto literals = to_bool_vars(actives);
+        check_sizes(times.size(), level_changes.size());
+        check_sizes(times.size(), literals.size());
+        ReservoirConstraint constraint = self.AddReservoirConstraint(min_level, max_level);
+        for (size_t i = 0; i < times.size(); i++) {
+          constraint.AddOptionalEvent(times[i], level_changes[i], literals[i]);
+        }
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_automaton",
+      [](CpModelBuilder& self, std::vector<LinearExpr> transition_expressions, int starting_state, const std::vector<int>& final_states, const std::vector<std::vector<int64_t>>& transition_triples) {
+        AutomatonConstraint constraint = self.AddAutomaton(transition_expressions, starting_state, final_states);
+        for (const auto& triple : transition_triples) {
+          if (triple.size() != 3) {
+            throw std::invalid_argument("Expected transitions to be [tail, head, label]");
+          }
+          constraint.AddTransition(triple[0], triple[1], triple[2]);
+        }
+        return Constraint(constraint);
+      })
+    .define_method(
+      "add_element",
+      [](CpModelBuilder& self, LinearExpr index, std::vector<LinearExpr> expressions, LinearExpr target) {
+        return self.AddElement(index, expressions, target);
+      })
     .define_method(
       "maximize",
       [](CpModelBuilder& self, LinearExpr expr) {
@@ -327,6 +1339,62 @@ void init_constraint(Rice::Module& m) {
           );
         }
       })
+    // replaces the hints with the solution, writing directly to the proto
+    .define_method(
+      "add_hints_from_response",
+      [](CpModelBuilder& self, const CpSolverResponse& response) {
+        const auto& solution = response.solution();
+        if (solution.empty()) {
+          throw std::invalid_argument("Response has no solution");
+        }
+        if (solution.size() > self.Proto().variables_size()) {
+          throw std::invalid_argument("Response has more variables than model");
+        }
+
+        self.ClearHints();
+        auto hint = self.MutableProto()->mutable_solution_hint();
+        hint->mutable_vars()->Reserve(solution.size());
+        hint->mutable_values()->Reserve(solution.size());
+        for (int i = 0; i < solution.size(); i++) {
+          hint->add_vars(i);
+          hint->add_values(solution[i]);
+        }
+      })
+    // vars can be variables, proto indices, or a packed String of indices (l*)
+    // values can be an Array or a packed String (q*)
+    .define_method(
+      "add_hints",
+      [](CpModelBuilder& self, Object vars, Object values) {
+        auto v = read_buffer<int64_t>(values);
+
+        if (vars.is_a(rb_cString)) {
+          auto indices = read_buffer<int32_t>(vars);
+          check_sizes(indices.size(), v.size());
+          for (size_t i = 0; i < indices.size(); i++) {
+            self.AddHint(self.GetIntVarFromProtoIndex(model_variable_index(self, indices[i])), v[i]);
+          }
+          return;
+        }
+
+        Array a(vars);
+        check_sizes(a.size(), v.size());
+        for (size_t i = 0; i < v.size(); i++) {
+          Object var(a[i]);
+          if (var.is_a(rb_cBoolVar)) {
+            self.AddHint(Rice::detail::From_Ruby<BoolVar>().convert(var.value()), v[i] != 0);
+          } else if (var.is_a(rb_cInteger)) {
+            auto index = Rice::detail::From_Ruby<int>().convert(var.value());
+            self.AddHint(self.GetIntVarFromProtoIndex(model_variable_index(self, index)), v[i]);
+          } else {
+            self.AddHint(Rice::detail::From_Ruby<IntVar>().convert(var.value()), v[i]);
+          }
+        }
+      })
+    .define_method(
+      "num_hints",
+      [](CpModelBuilder& self) {
+        return self.Proto().solution_hint().vars_size();
+      })
     .define_method(
       "clear_hints",
       [](CpModelBuilder& self) {
@@ -360,6 +1428,114 @@ void init_constraint(Rice::Module& m) {
           throw Rice::Exception(rb_eRuntimeError, "PrintToString failed");
         }
         return proto_string;
+      })
+    .define_method(
+      "to_binary",
+      [](CpModelBuilder& self) {
+        std::string data = self.Proto().SerializeAsString();
+        return String(rb_str_new(data.data(), data.size()));
+      })
+    .define_singleton_function(
+      "from_binary",
+      [](const std::string& data) {
+        CpModelProto proto;
+        parse_model(data.data(), data.size(), false, &proto);
+        return import_model(proto);
+      })
+    .define_singleton_function(
+      "load_file",
+      [](const std::string& path) {
+        CpModelProto proto;
+        load_model_file(path, &proto);
+        return import_model(proto);
+      })
+    .define_method(
+      "num_variables",
+      [](CpModelBuilder& self) {
+        return self.Proto().variables_size();
+      })
+    .define_method(
+      "num_constraints",
+      [](CpModelBuilder& self) {
+        return self.Proto().constraints_size();
+      })
+    .define_method(
+      "get_int_var_from_proto_index",
+      [](CpModelBuilder& self, int index) {
+        return self.GetIntVarFromProtoIndex(model_variable_index(self, index));
+      })
+    .define_method(
+      "get_bool_var_from_proto_index",
+      [](CpModelBuilder& self, int index) {
+        const auto& domain = self.Proto().variables(model_variable_index(self, index)).domain();
+        if (domain.size() != 2 || domain[0] < 0 || domain[1] > 1) {
+          throw std::invalid_argument("Not a boolean variable: " + std::to_string(index));
+        }
+        return self.GetBoolVarFromProtoIndex(index);
+      })
+    .define_method(
+      "get_interval_var_from_proto_index",
+      [](CpModelBuilder& self, int index) {
+        if (index < 0 || index >= self.Proto().constraints_size()) {
+          throw std::out_of_range("Index out of range");
+        }
+        if (!self.Proto().constraints(index).has_interval()) {
+          throw std::invalid_argument("Not an interval: " + std::to_string(index));
+        }
+        return self.GetIntervalVarFromProtoIndex(index);
+      })
+    // a deep copy, so variables and constraints keep the same indices
+    .define_method(
+      "_fork",
+      [](CpModelBuilder& self) {
+        return import_model(self.Proto());
+      })
+    .define_method(
+      "_tighten_domain",
+      [](CpModelBuilder& self, const IntVar& var, const Domain& domain) {
+        auto proto = self.MutableProto()->mutable_variables(model_variable_index(self, var.index()));
+        auto tightened = ReadDomainFromProto(*proto).IntersectionWith(domain);
+        if (tightened.IsEmpty()) {
+          throw std::invalid_argument("Empty domain");
+        }
+        FillDomainInProto(tightened, proto);
+      })
+    .define_method(
+      "_constraint_index",
+      [](CpModelBuilder& self, const Constraint& constraint) -> Object {
+        // compares addresses, so the constraint must be from this model
+        const auto* proto = &constraint.Proto();
+        const auto& constraints = self.Proto().constraints();
+        for (int i = 0; i < constraints.size(); i++) {
+          if (&constraints[i] == proto) {
+            return Rice::detail::To_Ruby<int>().convert(i);
+          }
+        }
+        return Qnil;
+      })
+    .define_method(
+      "_remove_constraint",
+      [](CpModelBuilder& self, int index) {
+        if (index < 0 || index >= self.Proto().constraints_size()) {
+          throw std::out_of_range("Index out of range");
+        }
+        auto proto = self.MutableProto()->mutable_constraints(index);
+        if (proto->has_interval()) {
+          throw std::invalid_argument("Cannot remove interval");
+        }
+        // an empty constraint keeps the indices of later constraints
+        proto->Clear();
+      })
+    .define_method(
+      "_variable_index",
+      [](CpModelBuilder& self, const std::string& name) -> Object {
+        const auto& variables = self.Proto().variables();
+        for (int i = 0; i < variables.size(); i++) {
+          if (variables[i].name() == name) {
+            return Rice::detail::To_Ruby<int>().convert(i);
+          }
+        }
+        return Qnil;
       });
 
   Rice::define_class_under<CpSolverResponse>(m, "CpSolverResponse")
@@ -367,6 +1543,23 @@ void init_constraint(Rice::Module& m) {
     .define_method("num_conflicts", &CpSolverResponse::num_conflicts)
     .define_method("num_branches", &CpSolverResponse::num_branches)
     .define_method("wall_time", &CpSolverResponse::wall_time)
+    .define_method("user_time", &CpSolverResponse::user_time)
+    .define_method("deterministic_time", &CpSolverResponse::deterministic_time)
+    .define_method("best_objective_bound", &CpSolverResponse::best_objective_bound)
+    .define_method("inner_objective_lower_bound", &CpSolverResponse::inner_objective_lower_bound)
+    .define_method("gap_integral", &CpSolverResponse::gap_integral)
+    .define_method("num_booleans", &CpSolverResponse::num_booleans)
+    .define_method("num_fixed_booleans", &CpSolverResponse::num_fixed_booleans)
+    .define_method("num_integers", &CpSolverResponse::num_integers)
+    .define_method("num_restarts", &CpSolverResponse::num_restarts)
+    .define_method("num_lp_iterations", &CpSolverResponse::num_lp_iterations)
+    .define_method("num_binary_propagations", &CpSolverResponse::num_binary_propagations)
+    .define_method("num_integer_propagations", &CpSolverResponse::num_integer_propagations)
+    .define_method(
+      "response_stats",
+      [](CpSolverResponse& self) {
+        return CpSolverResponseStats(self, true);
+      })
     .define_method(
       "solution_integer_value",
       [](CpSolverResponse& self, IntVar& x) {
@@ -409,41 +1602,80 @@ void init_constraint(Rice::Module& m) {
         return a;
       });
 
+  Rice::define_class_under<SearchProgress>(m, "CpSolverProgress")
+    .define_constructor(Rice::Constructor<SearchProgress>())
+    .define_method("stop_reason", &SearchProgress::stop_reason)
+    .define_method("to_h", &SearchProgress::to_hash);
+
+  Rice::define_class_under<SolutionPool>(m, "CpSolutionPool")
+    .define_constructor(Rice::Constructor<SolutionPool, Array, int64_t, bool>())
+    .define_method("num_vars", &SolutionPool::num_vars)
+    .define_method("size", &SolutionPool::size)
+    .define_method("num_solutions", &SolutionPool::num_solutions)
+    .define_method("to_a", &SolutionPool::to_a)
+    .define_method("to_binary", &SolutionPool::to_binary)
+    .define_method("shift", &SolutionPool::shift)
+    .define_method("clear", &SolutionPool::clear);
+
   Rice::define_class_under(m, "CpSolver")
+    .define_singleton_function("_solve_many", &solve_many)
     .define_method(
       "_solve",
-      [](Object self, CpModelBuilder& model, SatParameters& parameters, Object callback) {
+      [](Object self, CpModelBuilder& model, SatParameters& parameters, Object callback, Object log_callback, SearchProgress& progress, double relative_gap, double absolute_gap, double no_improvement_time, double target_objective, Object solution_pool) {
+        bool has_callback = !callback.is_nil();
+        SolutionPool* pool = solution_pool.is_nil() ? nullptr : Rice::detail::From_Ruby<SolutionPool*>().convert(solution_pool.value());
+        if (pool != nullptr) {
+          pool->check_model(model);
+        }
+        bool has_log_callback = !log_callback.is_nil();
+
         Model m;
-        m.Add(NewSatParameters(parameters));
+        if (has_log_callback) {
+          // send the log to the callback instead of stdout
+          SatParameters log_parameters = parameters;
+          log_parameters.set_log_search_progress(true);
+          log_parameters.set_log_to_stdout(false);
+          m.Add(NewSatParameters(log_parameters));
+        } else {
+          m.Add(NewSatParameters(parameters));
+        }
 
         std::atomic<bool> done{false};
+        std::atomic<bool> stopped{false};
         Channel<CpSolverResponse> channel;
-        Rice::Object ruby_thread;
+        Channel<std::string> log_channel;
         std::optional<Rice::Exception> exception;
 
-        auto with_gvl = [](std::function<void()> f) {
-          auto ruby_wrapper = [](void* arg) -> void* {
-            (*static_cast<decltype(f)*>(arg))();
-            return nullptr;
-          };
-          rb_thread_call_with_gvl(ruby_wrapper, &f);
-        };
-
         auto ruby_observer = [&]() {
           return Rice::detail::no_gvl([&]() {
             while (true) {
-              if (done.load() && channel.empty()) {
+              if (done.load() && channel.empty() && log_channel.empty()) {
                 break;
               }
 
               while (true) {
                 std::optional<CpSolverResponse> response = channel.recv_timeout(std::chrono::milliseconds(10));
-                if (!response) {
+                std::vector<std::string> log_messages = log_channel.drain();
+                if (!response && log_messages.empty()) {
                   break;
                 }
 
                 bool stop = false;
                 with_gvl([&]() {
+                  try {
+                    for (const auto& message : log_messages) {
+                      log_callback.call("call", message);
+                    }
+                  } catch (const Rice::Exception& e) {
+                    exception = e;
+                    stop = true;
+                    return;
+                  }
+
+                  if (!response) {
+                    return;
+                  }
+
                   try {
                     try {
                       callback.call("response=", response.value());
@@ -460,8 +1692,12 @@ void init_constraint(Rice::Module& m) {
                   }
                 });
 
+                // stop sending, and free queued messages and blocked solver threads
                 if (stop) {
+                  stopped = true;
                   StopSearch(&m);
+                  channel.close();
+                  log_channel.close();
                   return Qnil;
                 }
               }
@@ -474,33 +1710,66 @@ void init_constraint(Rice::Module& m) {
           });
         };
 
-        auto ruby_wrapper = [](void* arg) {
-          return (*static_cast<decltype(ruby_observer)*>(arg))();
-        };
+        const auto& objective = model.Proto().objective();
+        bool maximize = objective.scaling_factor() < 0 || (model.Proto().has_floating_point_objective() && model.Proto().floating_point_objective().maximize());
+        StopRules rules(&m, &progress, maximize, relative_gap, absolute_gap, no_improvement_time, target_objective);
+        bool has_rules = rules.active();
 
-        if (!callback.is_nil()) {
-          ruby_thread = Rice::detail::protect([&]() {
-            return rb_thread_create(ruby_wrapper, &ruby_observer);
-          });
+        progress.reset();
+        m.Add(NewFeasibleSolutionObserver(
+          [&](const CpSolverResponse& response) {
+            progress.add_solution(response);
+            if (pool != nullptr && !pool->add(response)) {
+              progress.set_stop_reason("solution_limit");
+              StopSearch(&m);
+            }
+            if (has_rules) {
+              rules.on_solution(response.objective_value(), response.best_objective_bound());
+            }
+            if (has_callback && !stopped) {
+              channel.send_bounded(response, kMaxQueuedSolutions);
+            }
+          })
+        );
+        m.Add(NewBestBoundCallback(
+          [&](double bound) {
+            progress.set_best_bound(bound);
+            if (has_rules) {
+              rules.on_bound(bound);
+            }
+          })
+        );
 
-          m.Add(NewFeasibleSolutionObserver(
-            [&](const CpSolverResponse& response) {
-              channel.send(response);
-            })
-          );
+        if (has_log_callback) {
+          m.GetOrCreate<SolverLogger>()->AddInfoLoggingCallback(
+            [&](const std::string& message) {
+              if (!stopped && !log_channel.try_send(message, kMaxLogMessages)) {
+                progress.add_dropped_log_message();
+              }
+            });
         }
 
-        CpSolverResponse response = Rice::detail::no_gvl([&]() {
-          return SolveCpModel(model.Build(), &m);
+        // joins the observer even if the solve throws
+        RubyThreadGuard ruby_thread(done);
+        if (has_callback || has_log_callback) {
+          ruby_thread.start(ruby_observer);
+        }
+
+        CpSolverResponse response = no_gvl("solve.cp_sat", [&]() {
+          if (has_rules) {
+            rules.start();
+          }
+          auto response = SolveCpModel(model.Build(), &m);
+          if (has_rules) {
+            rules.finish();
+          }
+          return response;
         });
 
-        if (!callback.is_nil()) {
-          done = true;
-          ruby_thread.call("value");
+        ruby_thread.join();
 
-          if (exception.has_value()) {
-            throw exception.value();
-          }
+        if (exception.has_value()) {
+          throw exception.value();
         }
 
         return response;
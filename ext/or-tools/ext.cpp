@@ -3,6 +3,8 @@
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "instrumentation.hpp"
+
 using operations_research::CppBridge;
 using operations_research::CppFlags;
 
@@ -20,6 +22,28 @@ void Init_ext() {
 
   m.define_singleton_function("lib_version", &operations_research::OrToolsVersionString);
 
+  // instrumentation defined in Ruby
+  m.define_singleton_function(
+    "_instrumentation_enabled=",
+    [](bool enabled) {
+      Instrumentation::instance().set_enabled(enabled);
+    });
+  m.define_singleton_function(
+    "_native_stats",
+    []() {
+      return Instrumentation::instance().to_hash();
+    });
+  m.define_singleton_function(
+    "_take_native_events",
+    []() {
+      return Instrumentation::instance().take_events();
+    });
+  m.define_singleton_function(
+    "_reset_native_stats",
+    []() {
+      Instrumentation::instance().reset();
+    });
+
   init_assignment(m);
   init_bin_packing(m);
   init_constraint(m);
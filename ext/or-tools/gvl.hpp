@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <optional>
+
+#include <rice/rice.hpp>
+
+inline void with_gvl(std::function<void()> f) {
+  auto ruby_wrapper = [](void* arg) -> void* {
+    (*static_cast<std::function<void()>*>(arg))();
+    return nullptr;
+  };
+  rb_thread_call_with_gvl(ruby_wrapper, &f);
+}
+
+// f must outlive the thread
+template<typename F>
+Rice::Object create_ruby_thread(F& f) {
+  auto ruby_wrapper = [](void* arg) -> VALUE {
+    return (*static_cast<F*>(arg))();
+  };
+  return Rice::detail::protect([&]() {
+    return rb_thread_create(ruby_wrapper, &f);
+  });
+}
+
+// like Rice::detail::no_gvl, but calls ubf if the Ruby thread is interrupted
+// uses RB_NOGVL_INTR_FAIL so Ruby never longjmps through C++ frames here
+// pending interrupts are raised as C++ exceptions (callers should call
+// Rice::detail::protect(rb_thread_check_ints) once their threads are joined)
+template<typename F, typename U>
+auto no_gvl_interruptible(F func, U ubf) -> decltype(func()) {
+  std::optional<decltype(func())> result;
+  std::exception_ptr error;
+  bool ran = false;
+
+  auto call = [&]() {
+    ran = true;
+    try {
+      result.emplace(func());
+    } catch (...) {
+      error = std::current_exception();
+    }
+  };
+
+  while (!ran) {
+    rb_nogvl(
+      [](void* arg) -> void* {
+        (*static_cast<decltype(call)*>(arg))();
+        return nullptr;
+      },
+      &call,
+      [](void* arg) {
+        (*static_cast<U*>(arg))();
+      },
+      &ubf,
+      RB_NOGVL_INTR_FAIL
+    );
+
+    // func is skipped when an interrupt is already pending
+    if (!ran) {
+      Rice::detail::protect(rb_thread_check_ints);
+    }
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return std::move(result.value());
+}
+
+// sets done and joins a thread from create_ruby_thread on every path,
+// since the thread uses locals from the calling frame
+// declare after the locals the thread uses so it is destroyed first
+class RubyThreadGuard {
+  public:
+    explicit RubyThreadGuard(std::atomic<bool>& done) : done_(done) {}
+
+    RubyThreadGuard(const RubyThreadGuard&) = delete;
+    RubyThreadGuard& operator=(const RubyThreadGuard&) = delete;
+
+    ~RubyThreadGuard() {
+      try {
+        join();
+      } catch (...) {
+        // already unwinding or the thread is joined
+      }
+    }
+
+    template<typename F>
+    void start(F& f) {
+      thread_ = create_ruby_thread(f);
+    }
+
+    // keeps waiting if interrupted, then raises the interrupt
+    void join() {
+      done_ = true;
+      if (thread_.is_nil()) {
+        return;
+      }
+
+      std::exception_ptr error;
+      while (true) {
+        try {
+          thread_.call("value");
+          break;
+        } catch (...) {
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+
+        // value raises again if the thread itself raised
+        try {
+          if (!thread_.call("alive?").test()) {
+            break;
+          }
+        } catch (...) {
+          // interrupted again, keep waiting
+        }
+      }
+      thread_ = Rice::Object();
+
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+  private:
+    std::atomic<bool>& done_;
+    Rice::Object thread_;
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <rice/rice.hpp>
+
+#include "gvl.hpp"
+
+// opt-in counters for ORTools.instrument
+// when disabled, each hook is a single relaxed atomic load
+class Instrumentation {
+  public:
+    struct Timing {
+      uint64_t count = 0;
+      double time = 0;
+    };
+
+    struct Conversion {
+      uint64_t count = 0;
+      uint64_t allocations = 0;
+    };
+
+    struct Event {
+      std::string name;
+      double start;
+      double finish;
+    };
+
+    static Instrumentation& instance() {
+      static Instrumentation instance;
+      return instance;
+    }
+
+    static bool enabled() {
+      return instance().enabled_.load(std::memory_order_relaxed);
+    }
+
+    void set_enabled(bool enabled) {
+      enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    void record_phase(const std::string& name, double time, bool gvl_released) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto& timing = phases_[name];
+      timing.count++;
+      timing.time += time;
+      if (gvl_released) {
+        gvl_released_time_ += time;
+      }
+    }
+
+    // published by ORTools::Instrumentation after the native call returns
+    void record_event(const std::string& name, double start, double finish) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      events_.push_back({name, start, finish});
+    }
+
+    Rice::Array take_events() {
+      std::vector<Event> events;
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        events.swap(events_);
+      }
+
+      Rice::Array ret(rb_ary_new_capa(events.size()));
+      for (const auto& event : events) {
+        Rice::Array e;
+        e.push(event.name, false);
+        e.push(event.start, false);
+        e.push(event.finish, false);
+        ret.push(e, false);
+      }
+      return ret;
+    }
+
+    void record_conversion(const std::string& name, uint64_t allocations) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto& conversion = conversions_[name];
+      conversion.count++;
+      conversion.allocations += allocations;
+    }
+
+    Rice::Hash to_hash() {
+      std::lock_guard<std::mutex> guard(mutex_);
+
+      Rice::Hash phases;
+      for (const auto& [name, timing] : phases_) {
+        Rice::Hash h;
+        h[Rice::Symbol("count")] = timing.count;
+        h[Rice::Symbol("time")] = timing.time;
+        phases[name] = h;
+      }
+
+      Rice::Hash conversions;
+      for (const auto& [name, conversion] : conversions_) {
+        Rice::Hash h;
+        h[Rice::Symbol("count")] = conversion.count;
+        h[Rice::Symbol("allocations")] = conversion.allocations;
+        conversions[name] = h;
+      }
+
+      Rice::Hash result;
+      result[Rice::Symbol("phases")] = phases;
+      result[Rice::Symbol("conversions")] = conversions;
+      result[Rice::Symbol("gvl_released_time")] = gvl_released_time_;
+      return result;
+    }
+
+    void reset() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      phases_.clear();
+      conversions_.clear();
+      events_.clear();
+      gvl_released_time_ = 0;
+    }
+
+  private:
+    std::atomic<bool> enabled_ = false;
+    std::mutex mutex_;
+    std::map<std::string, Timing> phases_;
+    std::map<std::string, Conversion> conversions_;
+    std::vector<Event> events_;
+    double gvl_released_time_ = 0;
+};
+
+inline size_t total_allocated_objects() {
+  static VALUE key = ID2SYM(rb_intern("total_allocated_objects"));
+  return rb_gc_stat(key);
+}
+
+// times a solve phase for ORTools.stats and ORTools.subscribe subscribers
+// does not call Ruby, so subscribers never run while solver threads are active
+class InstrumentedPhase {
+  public:
+    explicit InstrumentedPhase(const char* name) : name_(name), enabled_(Instrumentation::enabled()) {
+      if (enabled_) {
+        start_ = std::chrono::system_clock::now();
+      }
+    }
+
+    void finish(bool gvl_released) {
+      if (!enabled_) {
+        return;
+      }
+
+      auto finish = std::chrono::system_clock::now();
+      double time = std::chrono::duration<double>(finish - start_).count();
+      Instrumentation::instance().record_phase(name_, time, gvl_released);
+      Instrumentation::instance().record_event(
+        name_,
+        std::chrono::duration<double>(start_.time_since_epoch()).count(),
+        std::chrono::duration<double>(finish.time_since_epoch()).count()
+      );
+    }
+
+  private:
+    const char* name_;
+    bool enabled_;
+    std::chrono::system_clock::time_point start_;
+};
+
+// counts Ruby allocations made while converting a value
+class InstrumentedConversion {
+  public:
+    explicit InstrumentedConversion(const char* name) : name_(name), enabled_(Instrumentation::enabled()) {
+      if (enabled_) {
+        allocated_ = total_allocated_objects();
+      }
+    }
+
+    void finish() {
+      if (enabled_) {
+        Instrumentation::instance().record_conversion(name_, total_allocated_objects() - allocated_);
+      }
+    }
+
+  private:
+    const char* name_;
+    bool enabled_;
+    size_t allocated_ = 0;
+};
+
+// like Rice::detail::no_gvl, but recorded as a phase
+// interrupts stay pending until the caller returns to Ruby instead of
+// longjmping past its destructors
+template<typename F>
+auto no_gvl(const char* phase, F func) -> decltype(func()) {
+  InstrumentedPhase instrumented(phase);
+  auto result = no_gvl_interruptible(func, []() {});
+  instrumented.finish(true);
+  return result;
+}
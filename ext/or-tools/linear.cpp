@@ -1,11 +1,22 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 
+#include <poll.h>
+#include <unistd.h>
+
 #include <ortools/linear_solver/linear_solver.h>
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "gvl.hpp"
+#include "instrumentation.hpp"
+
 using operations_research::MPConstraint;
 using operations_research::MPObjective;
 using operations_research::MPSolver;
@@ -49,6 +60,165 @@ namespace Rice::detail {
   };
 } // namespace Rice::detail
 
+// redirects stdout to a pipe until restore() or destruction
+// stdout is process-wide, so output from other threads is captured too
+class StdoutCapture {
+  public:
+    StdoutCapture() {
+      int fds[2];
+      if (pipe(fds) != 0) {
+        throw std::runtime_error{"Could not create pipe"};
+      }
+
+      fflush(stdout);
+      saved_stdout_ = dup(STDOUT_FILENO);
+      if (saved_stdout_ < 0 || dup2(fds[1], STDOUT_FILENO) < 0) {
+        if (saved_stdout_ >= 0) {
+          close(saved_stdout_);
+        }
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error{"Could not redirect stdout"};
+      }
+      close(fds[1]);
+      read_fd_ = fds[0];
+    }
+
+    StdoutCapture(const StdoutCapture&) = delete;
+    StdoutCapture& operator=(const StdoutCapture&) = delete;
+
+    ~StdoutCapture() {
+      restore();
+      close(read_fd_);
+    }
+
+    int read_fd() const {
+      return read_fd_;
+    }
+
+    // closes the write end of the pipe, so the reader gets EOF
+    void restore() {
+      if (saved_stdout_ < 0) {
+        return;
+      }
+
+      std::cout.flush();
+      fflush(stdout);
+      dup2(saved_stdout_, STDOUT_FILENO);
+      close(saved_stdout_);
+      saved_stdout_ = -1;
+    }
+
+  private:
+    int read_fd_ = -1;
+    int saved_stdout_ = -1;
+};
+
+// only these backends write their logs to stdout
+// others log with absl, so there is nothing to capture
+bool logs_to_stdout(MPSolver::OptimizationProblemType problem_type) {
+  switch (problem_type) {
+    case MPSolver::OptimizationProblemType::CLP_LINEAR_PROGRAMMING:
+    case MPSolver::OptimizationProblemType::CBC_MIXED_INTEGER_PROGRAMMING:
+    case MPSolver::OptimizationProblemType::SCIP_MIXED_INTEGER_PROGRAMMING:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// CLP, CBC, and SCIP have no message callback and write their logs directly
+// to stdout, so redirect it to a pipe and forward the output from a Ruby thread
+MPSolver::ResultStatus solve_with_log(MPSolver& self, MPSolverParameters& params, Object log) {
+  if (!logs_to_stdout(self.ProblemType())) {
+    throw std::invalid_argument("log is only supported for CLP, CBC, and SCIP");
+  }
+
+  // stdout is global, so only one solve can capture it at a time
+  static std::mutex capture_mutex;
+  Rice::detail::no_gvl([&]() {
+    capture_mutex.lock();
+    return true;
+  });
+  std::lock_guard<std::mutex> guard(capture_mutex, std::adopt_lock);
+
+  StdoutCapture capture;
+  std::atomic<bool> done{false};
+  std::optional<Rice::Exception> exception;
+
+  // reads until EOF, or until done if stdout was not restored (the solve threw)
+  auto ruby_reader = [&]() {
+    return Rice::detail::no_gvl([&]() {
+      char buffer[4096];
+      while (true) {
+        pollfd pfd{capture.read_fd(), POLLIN, 0};
+        int ready = poll(&pfd, 1, 10);
+        if (ready == 0) {
+          if (done.load()) {
+            break;
+          }
+          continue;
+        }
+        if (ready < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          break;
+        }
+
+        ssize_t n = read(capture.read_fd(), buffer, sizeof(buffer));
+        if (n <= 0) {
+          break;
+        }
+
+        // keep draining the pipe after an error so the solver does not block
+        if (!exception.has_value()) {
+          with_gvl([&]() {
+            try {
+              log.call("write", String(std::string(buffer, n)));
+            } catch (const Rice::Exception& e) {
+              exception = e;
+            }
+          });
+        }
+      }
+      return Qnil;
+    });
+  };
+
+  // destroyed before capture, so the reader is joined before the pipe is closed
+  RubyThreadGuard ruby_thread(done);
+  ruby_thread.start(ruby_reader);
+
+  bool output_enabled = self.OutputIsEnabled();
+  self.EnableOutput();
+
+  MPSolver::ResultStatus status;
+  try {
+    status = no_gvl("solve.mp_solver", [&]() {
+      return self.Solve(params);
+    });
+  } catch (...) {
+    if (!output_enabled) {
+      self.SuppressOutput();
+    }
+    throw;
+  }
+
+  if (!output_enabled) {
+    self.SuppressOutput();
+  }
+
+  capture.restore();
+  ruby_thread.join();
+
+  if (exception.has_value()) {
+    throw exception.value();
+  }
+
+  return status;
+}
+
 void init_linear(Rice::Module& m) {
   Rice::define_class_under<MPVariable>(m, "MPVariable")
     .define_method("name", &MPVariable::name)
@@ -194,6 +364,25 @@ void init_linear(Rice::Module& m) {
         // use milliseconds to match Python
         self.SetTimeLimit(absl::Milliseconds(time_limit));
       })
+    .define_method(
+      "num_threads=",
+      [](MPSolver& self, int num_threads) {
+        auto status = self.SetNumThreads(num_threads);
+        if (status.code() == absl::StatusCode::kInvalidArgument) {
+          throw std::invalid_argument(std::string{status.message()});
+        } else if (!status.ok()) {
+          throw std::runtime_error(std::string{status.message()});
+        }
+      })
+    .define_method("num_threads", &MPSolver::GetNumThreads)
+    .define_method(
+      "solver_specific_parameters=",
+      [](MPSolver& self, const std::string& parameters) {
+        if (!self.SetSolverSpecificParametersAsString(parameters)) {
+          throw std::invalid_argument("Invalid solver specific parameters");
+        }
+      })
+    .define_method("solver_specific_parameters", &MPSolver::GetSolverSpecificParametersAsString)
     .define_method(
       "infinity",
       [](MPSolver& self) {
@@ -209,6 +398,7 @@ void init_linear(Rice::Module& m) {
     .define_method("num_variables", &MPSolver::NumVariables)
     .define_method("num_constraints", &MPSolver::NumConstraints)
     .define_method("wall_time", &MPSolver::wall_time)
+    .define_method("output_enabled?", &MPSolver::OutputIsEnabled)
     .define_method("enable_output", &MPSolver::EnableOutput)
     .define_method("suppress_output", &MPSolver::SuppressOutput)
     .define_method("iterations", &MPSolver::iterations)
@@ -221,8 +411,15 @@ void init_linear(Rice::Module& m) {
       })
     .define_method(
       "_solve",
-      [](MPSolver& self, MPSolverParameters& params) {
-        auto status = self.Solve(params);
+      [](MPSolver& self, MPSolverParameters& params, Object log) {
+        MPSolver::ResultStatus status;
+        if (log.is_nil()) {
+          status = no_gvl("solve.mp_solver", [&]() {
+            return self.Solve(params);
+          });
+        } else {
+          status = solve_with_log(self, params, log);
+        }
 
         if (status == MPSolver::ResultStatus::OPTIMAL) {
           return Symbol("optimal");
@@ -1,22 +1,52 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <absl/log/check.h>
 #include <absl/status/statusor.h>
+#include <absl/time/time.h>
+#include <google/protobuf/text_format.h>
 #include <ortools/base/init_google.h>
 #include <ortools/math_opt/cpp/math_opt.h>
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "channel.hpp"
+#include "gvl.hpp"
+#include "instrumentation.hpp"
+
+using operations_research::SolveInterrupter;
+using operations_research::math_opt::BasisStatus;
+using operations_research::math_opt::Emphasis;
+using operations_research::math_opt::IncrementalSolver;
+using operations_research::math_opt::LPAlgorithm;
+using operations_research::math_opt::BoundedQuadraticExpression;
 using operations_research::math_opt::LinearConstraint;
+using operations_research::math_opt::LinearExpression;
 using operations_research::math_opt::Model;
+using operations_research::math_opt::NewIncrementalSolver;
+using operations_research::math_opt::QuadraticConstraint;
+using operations_research::math_opt::QuadraticExpression;
+using operations_research::math_opt::QuadraticTerm;
+using operations_research::math_opt::SecondOrderConeConstraint;
 using operations_research::math_opt::Solve;
 using operations_research::math_opt::SolveArguments;
+using operations_research::math_opt::SolveParameters;
 using operations_research::math_opt::SolveResult;
 using operations_research::math_opt::SolverType;
 using operations_research::math_opt::Termination;
 using operations_research::math_opt::TerminationReason;
 using operations_research::math_opt::Variable;
 
+using Rice::Object;
+using Rice::String;
+using Rice::Symbol;
+
 namespace Rice::detail {
   template<>
   struct Type<SolverType> {
@@ -63,6 +93,184 @@ namespace Rice::detail {
   };
 } // namespace Rice::detail
 
+template<typename T>
+std::optional<T> parse_flag(Object value) {
+  if (value.is_nil()) {
+    return std::nullopt;
+  }
+
+  std::string s = Symbol(value).str();
+  T result;
+  std::string error;
+  if (!AbslParseFlag(s, &result, &error)) {
+    throw std::invalid_argument("Unknown value: " + s);
+  }
+  return result;
+}
+
+template<typename T>
+Object unparse_flag(const std::optional<T>& value) {
+  if (!value.has_value()) {
+    return Qnil;
+  }
+  return Symbol(AbslUnparseFlag(value.value()));
+}
+
+template<typename T>
+void parse_text_format(const std::string& text, T* message) {
+  if (!google::protobuf::TextFormat::ParseFromString(text, message)) {
+    throw std::invalid_argument("Invalid parameters");
+  }
+}
+
+template<typename T>
+std::string print_text_format(const T& message) {
+  std::string text;
+  if (!google::protobuf::TextFormat::PrintToString(message, &text)) {
+    throw std::runtime_error("PrintToString failed");
+  }
+  return text;
+}
+
+// from Utils.index_expression
+LinearExpression linear_expression(Rice::Hash coeffs) {
+  LinearExpression expr;
+  for (const auto& entry : coeffs) {
+    Object key = entry.key;
+    auto coeff = Rice::detail::From_Ruby<double>().convert(entry.value.value());
+
+    if (key.is_nil()) {
+      expr += coeff;
+    } else {
+      expr += coeff * Rice::detail::From_Ruby<Variable>().convert(key.value());
+    }
+  }
+  return expr;
+}
+
+// to Utils.index_expression format
+Rice::Hash linear_expression_hash(const LinearExpression& expr) {
+  Rice::Hash coeffs;
+  for (const auto& [variable, coeff] : expr.terms()) {
+    coeffs[variable] = coeff;
+  }
+  if (expr.offset() != 0) {
+    coeffs[Object(Qnil)] = expr.offset();
+  }
+  return coeffs;
+}
+
+QuadraticExpression quadratic_expression(Rice::Hash coeffs) {
+  QuadraticExpression expr;
+  for (const auto& entry : coeffs) {
+    Object key = entry.key;
+    auto coeff = Rice::detail::From_Ruby<double>().convert(entry.value.value());
+
+    if (key.is_nil()) {
+      expr += coeff;
+    } else if (key.is_a(rb_cArray)) {
+      Rice::Array pair(key);
+      auto first = Rice::detail::From_Ruby<Variable>().convert(Object(pair[0]).value());
+      auto second = Rice::detail::From_Ruby<Variable>().convert(Object(pair[1]).value());
+      expr += QuadraticTerm(first, second, coeff);
+    } else {
+      expr += coeff * Rice::detail::From_Ruby<Variable>().convert(key.value());
+    }
+  }
+  return expr;
+}
+
+// dense array indexed by id (nil for deleted ids)
+// avoids creating a Ruby object and hash entry for every key
+template<typename K, typename V, typename F>
+Object dense_array(const absl::flat_hash_map<K, V>& map, F convert) {
+  int64_t size = 0;
+  for (const auto& [k, v] : map) {
+    size = std::max(size, k.id() + 1);
+  }
+
+  VALUE ary = rb_ary_new_capa(size);
+  rb_ary_resize(ary, size);
+  for (const auto& [k, v] : map) {
+    rb_ary_store(ary, k.id(), convert(v));
+  }
+  return Object(ary);
+}
+
+VALUE basis_status_symbol(BasisStatus status) {
+  return Symbol(std::string{EnumToString(status)}).value();
+}
+
+SolveResult solve_with_arguments(std::function<absl::StatusOr<SolveResult>(const SolveArguments&)> solve, const SolveParameters& parameters, Object log) {
+  SolveInterrupter interrupter;
+  SolveArguments args;
+  args.parameters = parameters;
+  args.interrupter = &interrupter;
+
+  std::atomic<bool> done{false};
+  Channel<std::string> channel;
+  std::optional<Rice::Exception> exception;
+
+  auto ruby_logger = [&]() {
+    return Rice::detail::no_gvl([&]() {
+      while (!(done.load() && channel.empty())) {
+        std::optional<std::string> message = channel.recv_timeout(std::chrono::milliseconds(10));
+        if (!message || exception.has_value()) {
+          continue;
+        }
+
+        with_gvl([&]() {
+          try {
+            log.call("write", String(message.value() + "\n"));
+          } catch (const Rice::Exception& e) {
+            exception = e;
+          }
+        });
+      }
+      return Qnil;
+    });
+  };
+
+  // joins the logger even if the solve throws or is interrupted
+  RubyThreadGuard ruby_thread(done);
+  if (!log.is_nil()) {
+    args.message_callback = [&](const std::vector<std::string>& messages) {
+      for (const auto& message : messages) {
+        channel.send(message);
+      }
+    };
+    ruby_thread.start(ruby_logger);
+  }
+
+  // interrupt the solve when the Ruby thread is interrupted
+  // (Thread#raise, Thread#kill, Timeout, or a signal)
+  InstrumentedPhase instrumented("solve.math_opt");
+  absl::StatusOr<SolveResult> result = no_gvl_interruptible(
+    [&]() {
+      return solve(args);
+    },
+    [&]() {
+      interrupter.Interrupt();
+    }
+  );
+  instrumented.finish(true);
+
+  ruby_thread.join();
+
+  // raise pending interrupt
+  Rice::detail::protect(rb_thread_check_ints);
+
+  if (exception.has_value()) {
+    throw exception.value();
+  }
+
+  if (!result.ok()) {
+    throw std::invalid_argument(std::string{result.status().message()});
+  }
+
+  return *result;
+}
+
 void init_math_opt(Rice::Module& m) {
   auto mathopt = Rice::define_module_under(m, "MathOpt");
 
@@ -73,13 +281,56 @@ void init_math_opt(Rice::Module& m) {
       [](Variable& self) {
         return std::string{self.name()};
       })
+    .define_method("lower_bound", &Variable::lower_bound)
+    .define_method("upper_bound", &Variable::upper_bound)
+    .define_method("integer?", &Variable::is_integer)
     .define_method(
       "_eql?",
       [](Variable& self, Variable& other) {
         return static_cast<bool>(self == other);
       });
 
-  Rice::define_class_under<LinearConstraint>(mathopt, "LinearConstraint");
+  Rice::define_class_under<LinearConstraint>(mathopt, "LinearConstraint")
+    .define_method("id", &LinearConstraint::id)
+    .define_method(
+      "name",
+      [](LinearConstraint& self) {
+        return std::string{self.name()};
+      })
+    .define_method("lower_bound", &LinearConstraint::lower_bound)
+    .define_method("upper_bound", &LinearConstraint::upper_bound)
+    .define_method("coefficient", &LinearConstraint::coefficient);
+
+  Rice::define_class_under<QuadraticConstraint>(mathopt, "QuadraticConstraint")
+    .define_method("id", &QuadraticConstraint::id)
+    .define_method(
+      "name",
+      [](QuadraticConstraint& self) {
+        return std::string{self.name()};
+      });
+
+  Rice::define_class_under<SecondOrderConeConstraint>(mathopt, "SecondOrderConeConstraint")
+    .define_method("id", &SecondOrderConeConstraint::id)
+    .define_method(
+      "name",
+      [](SecondOrderConeConstraint& self) {
+        return std::string{self.name()};
+      })
+    .define_method(
+      "upper_bound",
+      [](SecondOrderConeConstraint& self) {
+        return linear_expression_hash(self.upper_bound());
+      })
+    .define_method(
+      "arguments_to_norm",
+      [](SecondOrderConeConstraint& self) {
+        auto arguments = self.arguments_to_norm();
+        Rice::Array ret(rb_ary_new_capa(arguments.size()));
+        for (const auto& argument : arguments) {
+          ret.push(linear_expression_hash(argument), false);
+        }
+        return ret;
+      });
 
   Rice::define_class_under<Termination>(mathopt, "Termination")
     .define_method(
@@ -108,6 +359,245 @@ void init_math_opt(Rice::Module& m) {
         } else {
           throw std::runtime_error{"Unknown termination reason"};
         }
+      })
+    .define_method(
+      "limit",
+      [](Termination& self) -> Object {
+        if (!self.limit.has_value()) {
+          return Qnil;
+        }
+        return Symbol(std::string{EnumToString(self.limit.value())});
+      });
+
+  Rice::define_class_under<SolveParameters>(mathopt, "SolveParameters")
+    .define_constructor(Rice::Constructor<SolveParameters>())
+    .define_method(
+      "enable_output",
+      [](SolveParameters& self) {
+        return self.enable_output;
+      })
+    .define_method(
+      "enable_output=",
+      [](SolveParameters& self, bool value) {
+        self.enable_output = value;
+      })
+    .define_method(
+      "time_limit",
+      [](SolveParameters& self) {
+        if (self.time_limit == absl::InfiniteDuration()) {
+          return std::optional<double>{};
+        }
+        return std::optional<double>{absl::ToDoubleSeconds(self.time_limit)};
+      })
+    .define_method(
+      "time_limit=",
+      [](SolveParameters& self, std::optional<double> value) {
+        // use seconds to match Python
+        self.time_limit = value.has_value() ? absl::Seconds(value.value()) : absl::InfiniteDuration();
+      })
+    .define_method(
+      "iteration_limit",
+      [](SolveParameters& self) {
+        return self.iteration_limit;
+      })
+    .define_method(
+      "iteration_limit=",
+      [](SolveParameters& self, std::optional<int64_t> value) {
+        self.iteration_limit = value;
+      })
+    .define_method(
+      "node_limit",
+      [](SolveParameters& self) {
+        return self.node_limit;
+      })
+    .define_method(
+      "node_limit=",
+      [](SolveParameters& self, std::optional<int64_t> value) {
+        self.node_limit = value;
+      })
+    .define_method(
+      "cutoff_limit",
+      [](SolveParameters& self) {
+        return self.cutoff_limit;
+      })
+    .define_method(
+      "cutoff_limit=",
+      [](SolveParameters& self, std::optional<double> value) {
+        self.cutoff_limit = value;
+      })
+    .define_method(
+      "objective_limit",
+      [](SolveParameters& self) {
+        return self.objective_limit;
+      })
+    .define_method(
+      "objective_limit=",
+      [](SolveParameters& self, std::optional<double> value) {
+        self.objective_limit = value;
+      })
+    .define_method(
+      "best_bound_limit",
+      [](SolveParameters& self) {
+        return self.best_bound_limit;
+      })
+    .define_method(
+      "best_bound_limit=",
+      [](SolveParameters& self, std::optional<double> value) {
+        self.best_bound_limit = value;
+      })
+    .define_method(
+      "solution_limit",
+      [](SolveParameters& self) {
+        return self.solution_limit;
+      })
+    .define_method(
+      "solution_limit=",
+      [](SolveParameters& self, std::optional<int32_t> value) {
+        self.solution_limit = value;
+      })
+    .define_method(
+      "threads",
+      [](SolveParameters& self) {
+        return self.threads;
+      })
+    .define_method(
+      "threads=",
+      [](SolveParameters& self, std::optional<int32_t> value) {
+        if (value.has_value() && value.value() < 1) {
+          throw std::invalid_argument("threads must be positive");
+        }
+        self.threads = value;
+      })
+    .define_method(
+      "random_seed",
+      [](SolveParameters& self) {
+        return self.random_seed;
+      })
+    .define_method(
+      "random_seed=",
+      [](SolveParameters& self, std::optional<int32_t> value) {
+        self.random_seed = value;
+      })
+    .define_method(
+      "absolute_gap_tolerance",
+      [](SolveParameters& self) {
+        return self.absolute_gap_tolerance;
+      })
+    .define_method(
+      "absolute_gap_tolerance=",
+      [](SolveParameters& self, std::optional<double> value) {
+        self.absolute_gap_tolerance = value;
+      })
+    .define_method(
+      "relative_gap_tolerance",
+      [](SolveParameters& self) {
+        return self.relative_gap_tolerance;
+      })
+    .define_method(
+      "relative_gap_tolerance=",
+      [](SolveParameters& self, std::optional<double> value) {
+        self.relative_gap_tolerance = value;
+      })
+    .define_method(
+      "solution_pool_size",
+      [](SolveParameters& self) {
+        return self.solution_pool_size;
+      })
+    .define_method(
+      "solution_pool_size=",
+      [](SolveParameters& self, std::optional<int32_t> value) {
+        self.solution_pool_size = value;
+      })
+    .define_method(
+      "lp_algorithm",
+      [](SolveParameters& self) {
+        return unparse_flag(self.lp_algorithm);
+      })
+    .define_method(
+      "lp_algorithm=",
+      [](SolveParameters& self, Object value) {
+        self.lp_algorithm = parse_flag<LPAlgorithm>(value);
+      })
+    .define_method(
+      "presolve",
+      [](SolveParameters& self) {
+        return unparse_flag(self.presolve);
+      })
+    .define_method(
+      "presolve=",
+      [](SolveParameters& self, Object value) {
+        self.presolve = parse_flag<Emphasis>(value);
+      })
+    .define_method(
+      "cuts",
+      [](SolveParameters& self) {
+        return unparse_flag(self.cuts);
+      })
+    .define_method(
+      "cuts=",
+      [](SolveParameters& self, Object value) {
+        self.cuts = parse_flag<Emphasis>(value);
+      })
+    .define_method(
+      "heuristics",
+      [](SolveParameters& self) {
+        return unparse_flag(self.heuristics);
+      })
+    .define_method(
+      "heuristics=",
+      [](SolveParameters& self, Object value) {
+        self.heuristics = parse_flag<Emphasis>(value);
+      })
+    .define_method(
+      "scaling",
+      [](SolveParameters& self) {
+        return unparse_flag(self.scaling);
+      })
+    .define_method(
+      "scaling=",
+      [](SolveParameters& self, Object value) {
+        self.scaling = parse_flag<Emphasis>(value);
+      })
+    // solver specific parameters use protobuf text format
+    .define_method(
+      "glop",
+      [](SolveParameters& self) {
+        return print_text_format(self.glop);
+      })
+    .define_method(
+      "glop=",
+      [](SolveParameters& self, const std::string& value) {
+        parse_text_format(value, &self.glop);
+      })
+    .define_method(
+      "cp_sat",
+      [](SolveParameters& self) {
+        return print_text_format(self.cp_sat);
+      })
+    .define_method(
+      "cp_sat=",
+      [](SolveParameters& self, const std::string& value) {
+        parse_text_format(value, &self.cp_sat);
+      })
+    .define_method(
+      "pdlp",
+      [](SolveParameters& self) {
+        return print_text_format(self.pdlp);
+      })
+    .define_method(
+      "pdlp=",
+      [](SolveParameters& self, const std::string& value) {
+        parse_text_format(value, &self.pdlp);
+      })
+    .define_method(
+      "gscip",
+      [](SolveParameters& self) {
+        return print_text_format(self.gscip);
+      })
+    .define_method(
+      "gscip=",
+      [](SolveParameters& self, const std::string& value) {
+        parse_text_format(value, &self.gscip);
       });
 
   Rice::define_class_under<SolveResult>(mathopt, "SolveResult")
@@ -129,6 +619,46 @@ void init_math_opt(Rice::Module& m) {
           map[k] = v;
         }
         return map;
+      })
+    .define_method(
+      "variable_values_array",
+      [](SolveResult& self) -> Object {
+        if (!self.has_primal_feasible_solution()) {
+          return Qnil;
+        }
+        return dense_array(self.variable_values(), rb_float_new);
+      })
+    .define_method(
+      "reduced_costs_array",
+      [](SolveResult& self) -> Object {
+        if (!self.has_dual_feasible_solution()) {
+          return Qnil;
+        }
+        return dense_array(self.reduced_costs(), rb_float_new);
+      })
+    .define_method(
+      "dual_values_array",
+      [](SolveResult& self) -> Object {
+        if (!self.has_dual_feasible_solution()) {
+          return Qnil;
+        }
+        return dense_array(self.dual_values(), rb_float_new);
+      })
+    .define_method(
+      "variable_status_array",
+      [](SolveResult& self) -> Object {
+        if (!self.has_basis()) {
+          return Qnil;
+        }
+        return dense_array(self.variable_status(), basis_status_symbol);
+      })
+    .define_method(
+      "constraint_status_array",
+      [](SolveResult& self) -> Object {
+        if (!self.has_basis()) {
+          return Qnil;
+        }
+        return dense_array(self.constraint_status(), basis_status_symbol);
       });
 
   Rice::define_class_under<Model>(mathopt, "Model")
@@ -148,8 +678,28 @@ void init_math_opt(Rice::Module& m) {
       })
     .define_method(
       "_set_lower_bound",
-      [](Model& self, const LinearConstraint& constraint, double upper_bound) {
-        self.set_lower_bound(constraint, upper_bound);
+      [](Model& self, const LinearConstraint& constraint, double lower_bound) {
+        self.set_lower_bound(constraint, lower_bound);
+      })
+    .define_method(
+      "_set_variable_upper_bound",
+      [](Model& self, const Variable& variable, double upper_bound) {
+        self.set_upper_bound(variable, upper_bound);
+      })
+    .define_method(
+      "_set_variable_lower_bound",
+      [](Model& self, const Variable& variable, double lower_bound) {
+        self.set_lower_bound(variable, lower_bound);
+      })
+    .define_method(
+      "set_integer",
+      [](Model& self, const Variable& variable) {
+        self.set_integer(variable);
+      })
+    .define_method(
+      "set_continuous",
+      [](Model& self, const Variable& variable) {
+        self.set_continuous(variable);
       })
     .define_method("_set_coefficient", &Model::set_coefficient)
     .define_method(
@@ -157,7 +707,27 @@ void init_math_opt(Rice::Module& m) {
       [](Model& self, const Variable& variable, double value) {
         self.set_objective_coefficient(variable, value);
       })
+    .define_method(
+      "_set_objective_quadratic_coefficient",
+      [](Model& self, const Variable& first_variable, const Variable& second_variable, double value) {
+        self.set_objective_coefficient(first_variable, second_variable, value);
+      })
     .define_method("_clear_objective", &Model::clear_objective)
+    .define_method(
+      "_add_quadratic_constraint",
+      [](Model& self, Rice::Hash coeffs, double lower_bound, double upper_bound) {
+        return self.AddQuadraticConstraint(BoundedQuadraticExpression(quadratic_expression(coeffs), lower_bound, upper_bound));
+      })
+    .define_method(
+      "_add_second_order_cone_constraint",
+      [](Model& self, Rice::Array arguments_to_norm, Rice::Hash upper_bound) {
+        std::vector<LinearExpression> args;
+        args.reserve(arguments_to_norm.size());
+        for (const auto& v : arguments_to_norm) {
+          args.push_back(linear_expression(Rice::Hash(Object(v))));
+        }
+        return self.AddSecondOrderConeConstraint(args, linear_expression(upper_bound));
+      })
     .define_method(
       "_set_objective_offset",
       [](Model& self, double value) {
@@ -175,14 +745,37 @@ void init_math_opt(Rice::Module& m) {
       })
     .define_method(
       "_solve",
-      [](Model& self, SolverType solver_type) {
-        SolveArguments args;
-        auto result = Solve(self, solver_type, args);
+      [](Model& self, SolverType solver_type, const SolveParameters& parameters, Object log) {
+        return solve_with_arguments(
+          [&](const SolveArguments& args) {
+            return Solve(self, solver_type, args);
+          },
+          parameters,
+          log
+        );
+      });
+
+  Rice::define_class_under<IncrementalSolver>(mathopt, "IncrementalSolver")
+    .define_singleton_function(
+      "_new",
+      [](Model& model, SolverType solver_type) {
+        auto solver = NewIncrementalSolver(&model, solver_type);
 
-        if (!result.ok()) {
-          throw std::invalid_argument(std::string{result.status().message()});
+        if (!solver.ok()) {
+          throw std::invalid_argument(std::string{solver.status().message()});
         }
 
-        return *result;
+        return solver->release();
+      }, Rice::Return().takeOwnership())
+    .define_method(
+      "_solve",
+      [](IncrementalSolver& self, const SolveParameters& parameters, Object log) {
+        return solve_with_arguments(
+          [&](const SolveArguments& args) {
+            return self.Solve(args);
+          },
+          parameters,
+          log
+        );
       });
 }
@@ -1,31 +1,318 @@
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
+#include <ortools/graph/graph.h>
 #include <ortools/graph/max_flow.h>
 #include <ortools/graph/min_cost_flow.h>
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "buffer.hpp"
+#include "instrumentation.hpp"
+
+using operations_research::GenericMaxFlow;
+using operations_research::GenericMinCostFlow;
+using operations_research::MaxFlowStatusClass;
+using operations_research::MinCostFlowBase;
 using operations_research::SimpleMaxFlow;
 using operations_research::SimpleMinCostFlow;
 
 using Rice::Array;
+using Rice::Object;
 using Rice::Symbol;
 
+using Graph = util::ReverseArcStaticGraph<int32_t, int32_t>;
+
+// checked in one pass before any arcs are added, so a bad node
+// leaves the solver unchanged instead of partially updated
+void check_nodes(const std::vector<int32_t>& nodes) {
+  for (auto node : nodes) {
+    if (node < 0) {
+      throw std::invalid_argument("Invalid node");
+    }
+  }
+}
+
+// static graph built once, with arcs mapped back to the order they were added
+class FlowGraph {
+  public:
+    FlowGraph(Object tails, Object heads) {
+      auto t = read_buffer<int32_t>(tails);
+      auto h = read_buffer<int32_t>(heads);
+      check_sizes(t.size(), h.size());
+      check_nodes(t);
+      check_nodes(h);
+
+      graph_.ReserveArcs(t.size());
+      for (size_t i = 0; i < t.size(); i++) {
+        graph_.AddArc(t[i], h[i]);
+      }
+      graph_.Build(&arcs_);
+
+      if (arcs_.empty()) {
+        arcs_.resize(t.size());
+        for (size_t i = 0; i < t.size(); i++) {
+          arcs_[i] = i;
+        }
+      }
+    }
+
+    FlowGraph(const FlowGraph&) = delete;
+    FlowGraph& operator=(const FlowGraph&) = delete;
+
+    const Graph* graph() const {
+      return &graph_;
+    }
+
+    int32_t num_nodes() const {
+      return graph_.num_nodes();
+    }
+
+    int32_t num_arcs() const {
+      return arcs_.size();
+    }
+
+    int32_t arc(int32_t arc) const {
+      if (arc < 0 || arc >= num_arcs()) {
+        throw std::out_of_range("Invalid arc");
+      }
+      return arcs_[arc];
+    }
+
+    // reorders values from the order arcs were added to graph order
+    template<typename T>
+    std::vector<T> permute(const std::vector<T>& values) const {
+      check_sizes(arcs_.size(), values.size());
+      std::vector<T> result(values.size());
+      for (size_t i = 0; i < values.size(); i++) {
+        result[arcs_[i]] = values[i];
+      }
+      return result;
+    }
+
+    int32_t node(int32_t node) const {
+      if (node < 0 || node >= num_nodes()) {
+        throw std::out_of_range("Invalid node");
+      }
+      return node;
+    }
+
+  private:
+    Graph graph_;
+    std::vector<int32_t> arcs_;
+};
+
+class MaxFlow : public FlowGraph {
+  public:
+    MaxFlow(Object tails, Object heads, Object capacities) : FlowGraph(tails, heads) {
+      capacities_ = permute(read_buffer<int64_t>(capacities));
+    }
+
+    void set_arc_capacity(int32_t arc, int64_t capacity) {
+      capacities_[this->arc(arc)] = capacity;
+      if (solver_) {
+        solver_->SetArcCapacity(this->arc(arc), capacity);
+      }
+    }
+
+    int64_t capacity(int32_t arc) {
+      return capacities_[this->arc(arc)];
+    }
+
+    // the graph is reused, so changing the source or sink only recreates the solver
+    MaxFlowStatusClass::Status solve(int32_t source, int32_t sink) {
+      node(source);
+      node(sink);
+
+      if (!solver_ || source != source_ || sink != sink_) {
+        solver_ = std::make_unique<GenericMaxFlow<Graph, int64_t, int64_t>>(graph(), source, sink);
+        for (size_t i = 0; i < capacities_.size(); i++) {
+          solver_->SetArcCapacity(i, capacities_[i]);
+        }
+        source_ = source;
+        sink_ = sink;
+      }
+
+      solver_->Solve();
+      return solver_->status();
+    }
+
+    GenericMaxFlow<Graph, int64_t, int64_t>& solver() {
+      if (!solver_) {
+        throw std::runtime_error("Not solved");
+      }
+      return *solver_;
+    }
+
+  private:
+    std::vector<int64_t> capacities_;
+    std::unique_ptr<GenericMaxFlow<Graph, int64_t, int64_t>> solver_;
+    int32_t source_ = -1;
+    int32_t sink_ = -1;
+};
+
+class MinCostFlow : public FlowGraph {
+  public:
+    MinCostFlow(Object tails, Object heads, Object capacities, Object unit_costs) : FlowGraph(tails, heads) {
+      capacities_ = permute(read_buffer<int64_t>(capacities));
+      unit_costs_ = permute(read_buffer<int64_t>(unit_costs));
+      supplies_.resize(num_nodes());
+    }
+
+    void set_arc_capacity(int32_t arc, int64_t capacity) {
+      capacities_[this->arc(arc)] = capacity;
+      if (solver_) {
+        solver_->SetArcCapacity(this->arc(arc), capacity);
+      }
+    }
+
+    void set_arc_unit_cost(int32_t arc, int64_t unit_cost) {
+      unit_costs_[this->arc(arc)] = unit_cost;
+      if (solver_) {
+        solver_->SetArcUnitCost(this->arc(arc), unit_cost);
+      }
+    }
+
+    // the solver keeps the flow from the previous solve, which supplies
+    // cannot be adjusted against, so recreate it on the next solve
+    void set_node_supply(int32_t node, int64_t supply) {
+      supplies_[this->node(node)] = supply;
+      solver_.reset();
+    }
+
+    int64_t capacity(int32_t arc) {
+      return capacities_[this->arc(arc)];
+    }
+
+    int64_t unit_cost(int32_t arc) {
+      return unit_costs_[this->arc(arc)];
+    }
+
+    int64_t supply(int32_t node) {
+      return supplies_[this->node(node)];
+    }
+
+    MinCostFlowBase::Status solve() {
+      if (!solver_) {
+        solver_ = std::make_unique<GenericMinCostFlow<Graph, int64_t, int64_t>>(graph());
+        for (size_t i = 0; i < capacities_.size(); i++) {
+          solver_->SetArcCapacity(i, capacities_[i]);
+          solver_->SetArcUnitCost(i, unit_costs_[i]);
+        }
+        for (size_t i = 0; i < supplies_.size(); i++) {
+          solver_->SetNodeSupply(i, supplies_[i]);
+        }
+      }
+
+      solver_->Solve();
+      return solver_->status();
+    }
+
+    GenericMinCostFlow<Graph, int64_t, int64_t>& solver() {
+      if (!solver_) {
+        throw std::runtime_error("Not solved");
+      }
+      return *solver_;
+    }
+
+  private:
+    std::vector<int64_t> capacities_;
+    std::vector<int64_t> unit_costs_;
+    std::vector<int64_t> supplies_;
+    std::unique_ptr<GenericMinCostFlow<Graph, int64_t, int64_t>> solver_;
+};
+
+Symbol max_flow_status(MaxFlowStatusClass::Status status) {
+  if (status == MaxFlowStatusClass::Status::OPTIMAL) {
+    return Symbol("optimal");
+  } else if (status == MaxFlowStatusClass::Status::INT_OVERFLOW) {
+    return Symbol("possible_overflow");
+  } else if (status == MaxFlowStatusClass::Status::BAD_INPUT) {
+    return Symbol("bad_input");
+  } else if (status == MaxFlowStatusClass::Status::BAD_RESULT) {
+    return Symbol("bad_result");
+  } else if (status == MaxFlowStatusClass::Status::NOT_SOLVED) {
+    return Symbol("not_solved");
+  } else {
+    throw std::runtime_error{"Unknown status"};
+  }
+}
+
+Symbol min_cost_flow_status(MinCostFlowBase::Status status) {
+  if (status == MinCostFlowBase::Status::NOT_SOLVED) {
+    return Symbol("not_solved");
+  } else if (status == MinCostFlowBase::Status::OPTIMAL) {
+    return Symbol("optimal");
+  } else if (status == MinCostFlowBase::Status::FEASIBLE) {
+    return Symbol("feasible");
+  } else if (status == MinCostFlowBase::Status::INFEASIBLE) {
+    return Symbol("infeasible");
+  } else if (status == MinCostFlowBase::Status::UNBALANCED) {
+    return Symbol("unbalanced");
+  } else if (status == MinCostFlowBase::Status::BAD_RESULT) {
+    return Symbol("bad_result");
+  } else if (status == MinCostFlowBase::Status::BAD_COST_RANGE) {
+    return Symbol("bad_cost_range");
+  } else {
+    throw std::runtime_error{"Unknown status"};
+  }
+}
+
 void init_network_flows(Rice::Module& m) {
   Rice::define_class_under<SimpleMaxFlow>(m, "SimpleMaxFlow")
     .define_constructor(Rice::Constructor<SimpleMaxFlow>())
     .define_method("add_arc_with_capacity", &SimpleMaxFlow::AddArcWithCapacity)
+    .define_method(
+      "add_arcs_with_capacity",
+      [](SimpleMaxFlow& self, Object tails, Object heads, Object capacities) {
+        auto t = read_buffer<int32_t>(tails);
+        auto h = read_buffer<int32_t>(heads);
+        auto c = read_buffer<int64_t>(capacities);
+        check_sizes(t.size(), h.size());
+        check_sizes(t.size(), c.size());
+        check_nodes(t);
+        check_nodes(h);
+
+        for (size_t i = 0; i < t.size(); i++) {
+          self.AddArcWithCapacity(t[i], h[i], c[i]);
+        }
+      })
     .define_method("num_nodes", &SimpleMaxFlow::NumNodes)
     .define_method("num_arcs", &SimpleMaxFlow::NumArcs)
     .define_method("tail", &SimpleMaxFlow::Tail)
     .define_method("head", &SimpleMaxFlow::Head)
     .define_method("capacity", &SimpleMaxFlow::Capacity)
+    .define_method("set_arc_capacity", &SimpleMaxFlow::SetArcCapacity)
     .define_method("optimal_flow", &SimpleMaxFlow::OptimalFlow)
     .define_method("flow", &SimpleMaxFlow::Flow)
+    .define_method(
+      "flows",
+      [](SimpleMaxFlow& self) {
+        return write_buffer<int64_t>(self.NumArcs(), [&](size_t i) { return self.Flow(i); });
+      })
+    .define_method(
+      "nonzero_flows",
+      [](SimpleMaxFlow& self) {
+        Array ret;
+        auto num_arcs = self.NumArcs();
+        for (SimpleMaxFlow::ArcIndex i = 0; i < num_arcs; i++) {
+          auto flow = self.Flow(i);
+          if (flow != 0) {
+            Array pair(rb_ary_new_capa(2));
+            pair.push(i, false);
+            pair.push(flow, false);
+            ret.push(pair, false);
+          }
+        }
+        return ret;
+      })
     .define_method(
       "solve",
       [](SimpleMaxFlow& self, SimpleMaxFlow::NodeIndex source, SimpleMaxFlow::NodeIndex sink) {
-        auto status = self.Solve(source, sink);
+        auto status = no_gvl("solve.max_flow", [&]() {
+          return self.Solve(source, sink);
+        });
 
         if (status == SimpleMaxFlow::Status::OPTIMAL) {
           return Symbol("optimal");
@@ -45,7 +332,7 @@ void init_network_flows(Rice::Module& m) {
         std::vector<SimpleMaxFlow::NodeIndex> result;
         self.GetSourceSideMinCut(&result);
 
-        Array ret;
+        Array ret(rb_ary_new_capa(result.size()));
         for (const auto& it : result) {
           ret.push(it, false);
         }
@@ -57,7 +344,7 @@ void init_network_flows(Rice::Module& m) {
         std::vector<SimpleMaxFlow::NodeIndex> result;
         self.GetSinkSideMinCut(&result);
 
-        Array ret;
+        Array ret(rb_ary_new_capa(result.size()));
         for (const auto& it : result) {
           ret.push(it, false);
         }
@@ -65,40 +352,182 @@ void init_network_flows(Rice::Module& m) {
       });
 
   Rice::define_class_under<SimpleMinCostFlow>(m, "SimpleMinCostFlow")
-    .define_constructor(Rice::Constructor<SimpleMinCostFlow>())
+    .define_constructor(Rice::Constructor<SimpleMinCostFlow, int, int>(), Rice::Arg("reserve_num_nodes") = 0, Rice::Arg("reserve_num_arcs") = 0)
     .define_method("add_arc_with_capacity_and_unit_cost", &SimpleMinCostFlow::AddArcWithCapacityAndUnitCost)
+    .define_method(
+      "add_arcs_with_capacity_and_unit_cost",
+      [](SimpleMinCostFlow& self, Object tails, Object heads, Object capacities, Object unit_costs) {
+        auto t = read_buffer<int32_t>(tails);
+        auto h = read_buffer<int32_t>(heads);
+        auto c = read_buffer<int64_t>(capacities);
+        auto u = read_buffer<int64_t>(unit_costs);
+        check_sizes(t.size(), h.size());
+        check_sizes(t.size(), c.size());
+        check_sizes(t.size(), u.size());
+        check_nodes(t);
+        check_nodes(h);
+
+        for (size_t i = 0; i < t.size(); i++) {
+          self.AddArcWithCapacityAndUnitCost(t[i], h[i], c[i], u[i]);
+        }
+      })
     .define_method("set_node_supply", &SimpleMinCostFlow::SetNodeSupply)
+    .define_method(
+      "set_nodes_supplies",
+      [](SimpleMinCostFlow& self, Object nodes, Object supplies) {
+        auto n = read_buffer<int32_t>(nodes);
+        auto s = read_buffer<int64_t>(supplies);
+        check_sizes(n.size(), s.size());
+        check_nodes(n);
+
+        for (size_t i = 0; i < n.size(); i++) {
+          self.SetNodeSupply(n[i], s[i]);
+        }
+      })
     .define_method("optimal_cost", &SimpleMinCostFlow::OptimalCost)
     .define_method("maximum_flow", &SimpleMinCostFlow::MaximumFlow)
     .define_method("flow", &SimpleMinCostFlow::Flow)
+    .define_method(
+      "flows",
+      [](SimpleMinCostFlow& self) {
+        return write_buffer<int64_t>(self.NumArcs(), [&](size_t i) { return self.Flow(i); });
+      })
+    .define_method(
+      "nonzero_flows",
+      [](SimpleMinCostFlow& self) {
+        Array ret;
+        auto num_arcs = self.NumArcs();
+        for (SimpleMinCostFlow::ArcIndex i = 0; i < num_arcs; i++) {
+          auto flow = self.Flow(i);
+          if (flow != 0) {
+            Array pair(rb_ary_new_capa(2));
+            pair.push(i, false);
+            pair.push(flow, false);
+            ret.push(pair, false);
+          }
+        }
+        return ret;
+      })
     .define_method("num_nodes", &SimpleMinCostFlow::NumNodes)
     .define_method("num_arcs", &SimpleMinCostFlow::NumArcs)
     .define_method("tail", &SimpleMinCostFlow::Tail)
     .define_method("head", &SimpleMinCostFlow::Head)
     .define_method("capacity", &SimpleMinCostFlow::Capacity)
+    .define_method("set_arc_capacity", &SimpleMinCostFlow::SetArcCapacity)
     .define_method("supply", &SimpleMinCostFlow::Supply)
     .define_method("unit_cost", &SimpleMinCostFlow::UnitCost)
     .define_method(
       "solve",
       [](SimpleMinCostFlow& self) {
-        auto status = self.Solve();
+        auto status = no_gvl("solve.min_cost_flow", [&]() {
+          return self.Solve();
+        });
+        return min_cost_flow_status(status);
+      });
 
-        if (status == SimpleMinCostFlow::Status::NOT_SOLVED) {
-          return Symbol("not_solved");
-        } else if (status == SimpleMinCostFlow::Status::OPTIMAL) {
-          return Symbol("optimal");
-        } else if (status == SimpleMinCostFlow::Status::FEASIBLE) {
-          return Symbol("feasible");
-        } else if (status == SimpleMinCostFlow::Status::INFEASIBLE) {
-          return Symbol("infeasible");
-        } else if (status == SimpleMinCostFlow::Status::UNBALANCED) {
-          return Symbol("unbalanced");
-        } else if (status == SimpleMinCostFlow::Status::BAD_RESULT) {
-          return Symbol("bad_result");
-        } else if (status == SimpleMinCostFlow::Status::BAD_COST_RANGE) {
-          return Symbol("bad_cost_range");
-        } else {
-          throw std::runtime_error{"Unknown status"};
+  Rice::define_class_under<MaxFlow>(m, "MaxFlow")
+    .define_constructor(Rice::Constructor<MaxFlow, Object, Object, Object>())
+    .define_method(
+      "num_nodes",
+      [](MaxFlow& self) {
+        return self.num_nodes();
+      })
+    .define_method(
+      "num_arcs",
+      [](MaxFlow& self) {
+        return self.num_arcs();
+      })
+    .define_method("set_arc_capacity", &MaxFlow::set_arc_capacity)
+    .define_method("capacity", &MaxFlow::capacity)
+    .define_method(
+      "solve",
+      [](MaxFlow& self, int32_t source, int32_t sink) {
+        auto status = no_gvl("solve.max_flow", [&]() {
+          return self.solve(source, sink);
+        });
+        return max_flow_status(status);
+      })
+    .define_method(
+      "optimal_flow",
+      [](MaxFlow& self) {
+        return self.solver().GetOptimalFlow();
+      })
+    .define_method(
+      "flow",
+      [](MaxFlow& self, int32_t arc) {
+        return self.solver().Flow(self.arc(arc));
+      })
+    .define_method(
+      "flows",
+      [](MaxFlow& self) {
+        auto& solver = self.solver();
+        return write_buffer<int64_t>(self.num_arcs(), [&](size_t i) { return solver.Flow(self.arc(i)); });
+      })
+    .define_method(
+      "source_side_min_cut",
+      [](MaxFlow& self) {
+        std::vector<int32_t> result;
+        self.solver().GetSourceSideMinCut(&result);
+
+        Array ret(rb_ary_new_capa(result.size()));
+        for (const auto& it : result) {
+          ret.push(it, false);
+        }
+        return ret;
+      })
+    .define_method(
+      "sink_side_min_cut",
+      [](MaxFlow& self) {
+        std::vector<int32_t> result;
+        self.solver().GetSinkSideMinCut(&result);
+
+        Array ret(rb_ary_new_capa(result.size()));
+        for (const auto& it : result) {
+          ret.push(it, false);
         }
+        return ret;
+      });
+
+  Rice::define_class_under<MinCostFlow>(m, "MinCostFlow")
+    .define_constructor(Rice::Constructor<MinCostFlow, Object, Object, Object, Object>())
+    .define_method(
+      "num_nodes",
+      [](MinCostFlow& self) {
+        return self.num_nodes();
+      })
+    .define_method(
+      "num_arcs",
+      [](MinCostFlow& self) {
+        return self.num_arcs();
+      })
+    .define_method("set_arc_capacity", &MinCostFlow::set_arc_capacity)
+    .define_method("set_arc_unit_cost", &MinCostFlow::set_arc_unit_cost)
+    .define_method("set_node_supply", &MinCostFlow::set_node_supply)
+    .define_method("capacity", &MinCostFlow::capacity)
+    .define_method("unit_cost", &MinCostFlow::unit_cost)
+    .define_method("supply", &MinCostFlow::supply)
+    .define_method(
+      "solve",
+      [](MinCostFlow& self) {
+        auto status = no_gvl("solve.min_cost_flow", [&]() {
+          return self.solve();
+        });
+        return min_cost_flow_status(status);
+      })
+    .define_method(
+      "optimal_cost",
+      [](MinCostFlow& self) {
+        return self.solver().GetOptimalCost();
+      })
+    .define_method(
+      "flow",
+      [](MinCostFlow& self, int32_t arc) {
+        return self.solver().Flow(self.arc(arc));
+      })
+    .define_method(
+      "flows",
+      [](MinCostFlow& self) {
+        auto& solver = self.solver();
+        return write_buffer<int64_t>(self.num_arcs(), [&](size_t i) { return solver.Flow(self.arc(i)); });
       });
 }
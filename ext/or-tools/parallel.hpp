@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// calls f(i) for i in [0, n) on up to num_threads native threads
+// (0 uses the number of hardware threads) and rethrows the first exception
+template<typename F>
+void parallel_for(size_t n, int num_threads, F f) {
+  size_t threads = num_threads > 0 ? num_threads : std::thread::hardware_concurrency();
+  threads = std::max<size_t>(1, std::min(threads, n));
+
+  std::atomic<size_t> next = 0;
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t i = next++;
+      if (i >= n) {
+        break;
+      }
+
+      try {
+        f(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next = n;
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < threads; t++) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
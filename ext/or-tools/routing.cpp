@@ -6,6 +6,8 @@
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
 
+#include "instrumentation.hpp"
+
 using operations_research::Assignment;
 using operations_research::ConstraintSolverParameters;
 using operations_research::DefaultRoutingSearchParameters;
@@ -433,22 +435,28 @@ void init_routing(Rice::Module& m) {
       "_solve_with_parameters",
       [](RoutingModel& self, const RoutingSearchParameters& search_parameters, bool release_gvl) {
         if (release_gvl) {
-          return Rice::detail::no_gvl([&]() {
+          return no_gvl("solve.routing", [&]() {
             return self.SolveWithParameters(search_parameters);
           });
         } else {
-          return self.SolveWithParameters(search_parameters);
+          InstrumentedPhase instrumented("solve.routing");
+          auto solution = self.SolveWithParameters(search_parameters);
+          instrumented.finish(false);
+          return solution;
         }
       })
     .define_method(
       "_solve_from_assignment_with_parameters",
       [](RoutingModel& self, const Assignment& assignment, const RoutingSearchParameters& search_parameters, bool release_gvl) {
         if (release_gvl) {
-          return Rice::detail::no_gvl([&]() {
+          return no_gvl("solve.routing", [&]() {
             return self.SolveFromAssignmentWithParameters(&assignment, search_parameters);
           });
         } else {
-          return self.SolveFromAssignmentWithParameters(&assignment, search_parameters);
+          InstrumentedPhase instrumented("solve.routing");
+          auto solution = self.SolveFromAssignmentWithParameters(&assignment, search_parameters);
+          instrumented.finish(false);
+          return solution;
         }
       })
     .define_method("compute_lower_bound", &RoutingModel::ComputeLowerBound)
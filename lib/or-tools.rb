@@ -1,6 +1,9 @@
 # ext
 require "or_tools/ext"
 
+# instrumentation
+require_relative "or_tools/instrumentation"
+
 # expressions
 require_relative "or_tools/expression"
 require_relative "or_tools/comparison"
@@ -8,13 +11,19 @@ require_relative "or_tools/constant"
 require_relative "or_tools/product"
 require_relative "or_tools/variable"
 
+# assignment
+require_relative "or_tools/linear_sum_assignment"
+
 # bin packing
+require_relative "or_tools/bin_packer"
 require_relative "or_tools/knapsack_solver"
 
 # constraint
 require_relative "or_tools/cp_model"
+require_relative "or_tools/cp_solution_pool"
 require_relative "or_tools/cp_solver"
 require_relative "or_tools/cp_solver_solution_callback"
+require_relative "or_tools/sat_parameters"
 require_relative "or_tools/objective_solution_printer"
 require_relative "or_tools/var_array_solution_printer"
 require_relative "or_tools/var_array_and_objective_solution_printer"
@@ -23,7 +32,9 @@ require_relative "or_tools/var_array_and_objective_solution_printer"
 require_relative "or_tools/solver"
 
 # math opt
+require_relative "or_tools/math_opt/incremental_solver"
 require_relative "or_tools/math_opt/model"
+require_relative "or_tools/math_opt/solve_parameters"
 require_relative "or_tools/math_opt/variable"
 
 # routing
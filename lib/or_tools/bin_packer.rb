@@ -0,0 +1,19 @@
+module ORTools
+  class BinPacker
+    def self.new(sizes, capacities, dimensions: nil, values: nil)
+      if sizes.is_a?(Array) && sizes.first.is_a?(Array)
+        dimensions ||= sizes.first.size
+        sizes = sizes.flatten
+      end
+      if capacities.is_a?(Array) && capacities.first.is_a?(Array)
+        dimensions ||= capacities.first.size
+        capacities = capacities.flatten
+      end
+      super(sizes, capacities, dimensions || 1, values)
+    end
+
+    def solve(time_limit: nil, num_workers: nil)
+      _solve(time_limit || Float::INFINITY, num_workers || 0)
+    end
+  end
+end
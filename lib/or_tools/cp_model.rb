@@ -31,12 +31,66 @@ module ORTools
       end
     end
 
+    def add_linear_expression_in_domain(expr, domain, enforcement_literals = nil)
+      _add_linear_expression_in_domain(expr, domain, enforcement_literals)
+    end
+
     def sum(arr)
       Expression.new(arr)
     end
 
+    # variables and constraints from this model can be used with the copy
+    def fork
+      model = _fork
+      model.instance_variable_set(:@parent, [self, num_constraints])
+      model
+    end
+
+    def dup
+      fork
+    end
+
+    def tighten_domain(var, min_or_domain, max = nil)
+      domain = max.nil? ? min_or_domain : Domain.new(min_or_domain, max)
+      _tighten_domain(var, domain)
+    end
+
+    def remove_constraint(constraint)
+      index =
+        if constraint.is_a?(Integer)
+          constraint
+        else
+          constraint_index(constraint) || raise(ArgumentError, "Constraint not in model")
+        end
+      _remove_constraint(index)
+    end
+
+    def find_int_var(name)
+      index = _variable_index(name)
+      get_int_var_from_proto_index(index) if index
+    end
+
+    def find_bool_var(name)
+      index = _variable_index(name)
+      get_bool_var_from_proto_index(index) if index
+    end
+
     def inspect
       to_s
     end
+
+    private
+
+    # constraints added to a model before it was forked have the same index in the copy
+    def constraint_index(constraint)
+      model = self
+      limit = nil
+      while model
+        index = model._constraint_index(constraint)
+        return (index if limit.nil? || index < limit) if index
+        model, parent_limit = model.instance_variable_get(:@parent)
+        limit = [limit, parent_limit].compact.min
+      end
+    end
   end
 end
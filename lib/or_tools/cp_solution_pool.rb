@@ -0,0 +1,17 @@
+module ORTools
+  class CpSolutionPool
+    include Enumerable
+
+    def self.new(vars, limit: nil, unique: false)
+      super(vars, limit || 0, unique)
+    end
+
+    def each(&block)
+      to_a.each(&block)
+    end
+
+    def empty?
+      size == 0
+    end
+  end
+end
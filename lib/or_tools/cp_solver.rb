@@ -4,10 +4,28 @@ module ORTools
   class CpSolver
     extend Forwardable
 
-    def_delegators :@response, :objective_value, :num_conflicts, :num_branches, :wall_time
+    def_delegators :@response, :objective_value, :num_conflicts, :num_branches, :wall_time,
+      :user_time, :deterministic_time, :best_objective_bound, :num_booleans, :num_restarts,
+      :num_lp_iterations, :response_stats
 
-    def solve(model, observer = nil)
-      @response = _solve(model, parameters, observer)
+    attr_reader :response
+    attr_writer :parameters
+    attr_accessor :log_callback
+
+    # yields the index and response of each model as it finishes
+    # models are read from native threads, so do not modify them until this returns
+    # (including in the block)
+    def self.solve_many(models, total_threads: nil, per_model_time_limit: nil, parameters: nil, &block)
+      _solve_many(models, parameters || SatParameters.new, total_threads || 0, per_model_time_limit || Float::INFINITY, block)
+    end
+
+    # stopping rules are checked natively when the solution or bound improves
+    def solve(model, observer = nil, relative_gap: nil, absolute_gap: nil, no_improvement_time: nil, target_objective: nil)
+      rules = [relative_gap, absolute_gap, no_improvement_time, target_objective].map { |v| v.nil? ? Float::NAN : v.to_f }
+      # solution pools are filled natively instead of calling Ruby for each solution
+      pool = observer.is_a?(CpSolutionPool) ? observer : nil
+      observer = nil if pool
+      @response = _solve(model, parameters, observer, log_callback, search_progress, *rules, pool)
       observer.response = @response if observer
       @response.status
     end
@@ -37,5 +55,21 @@ module ORTools
     def parameters
       @parameters ||= SatParameters.new
     end
+
+    # the stopping rule that ended the last solve, if any
+    def stop_reason
+      search_progress.stop_reason
+    end
+
+    # safe to call from another thread during a solve
+    def progress
+      search_progress.to_h
+    end
+
+    private
+
+    def search_progress
+      @search_progress ||= CpSolverProgress.new
+    end
   end
 end
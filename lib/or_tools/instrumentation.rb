@@ -0,0 +1,155 @@
+module ORTools
+  module Instrumentation
+    @mutex = Mutex.new
+    @depth = 0
+    @subscribers = []
+    @event_id = 0
+
+    class << self
+      def enable
+        @mutex.synchronize do
+          @depth += 1
+          if @depth == 1
+            ORTools._instrumentation_enabled = true
+            trace_point.enable
+          end
+        end
+      end
+
+      def disable
+        @mutex.synchronize do
+          next if @depth == 0
+
+          @depth -= 1
+          if @depth == 0
+            trace_point.disable
+            ORTools._instrumentation_enabled = false
+          end
+        end
+        publish_events
+      end
+
+      def enabled?
+        @depth > 0
+      end
+
+      def stats
+        native = ORTools._native_stats
+        gvl_released_time = native[:gvl_released_time]
+        {
+          calls: calls.transform_values(&:dup),
+          phases: native[:phases],
+          conversions: native[:conversions],
+          native_time: @native_time || 0.0,
+          gvl_released_time: gvl_released_time,
+          gvl_held_time: [(@native_time || 0.0) - gvl_released_time, 0.0].max
+        }
+      end
+
+      def reset
+        @calls = nil
+        @native_time = 0.0
+        ORTools._reset_native_stats
+      end
+
+      def subscribe(callable = nil, &block)
+        subscriber = callable || block
+        @mutex.synchronize { @subscribers << subscriber }
+        subscriber
+      end
+
+      def unsubscribe(subscriber)
+        @mutex.synchronize { @subscribers.delete(subscriber) }
+      end
+
+      # subscribers get the same arguments as ActiveSupport::Notifications
+      # errors are reported instead of raised, since the solve already finished
+      def notify(name, start, finish)
+        name = "#{name}.or_tools"
+        id = @mutex.synchronize { @event_id += 1 }.to_s
+        start = Time.at(start)
+        finish = Time.at(finish)
+        payload = {}
+
+        @subscribers.each do |subscriber|
+          subscriber.call(name, start, finish, id, payload)
+        rescue => e
+          warn "[or-tools] Subscriber error: #{e.class}: #{e.message}"
+        end
+        if defined?(ActiveSupport::Notifications)
+          ActiveSupport::Notifications.publish(name, start, finish, id, payload)
+        end
+      end
+
+      private
+
+      def calls
+        @calls ||= Hash.new { |hash, key| hash[key] = {count: 0, time: 0.0} }
+      end
+
+      def publish_events
+        ORTools._take_native_events.each do |name, start, finish|
+          notify(name, start, finish)
+        end
+      end
+
+      # native methods are C functions, so only c_call and c_return are needed
+      def trace_point
+        @trace_point ||= TracePoint.new(:c_call, :c_return) do |tp|
+          name = method_name(tp.defined_class, tp.method_id)
+          next unless name
+
+          stack = (Thread.current[:or_tools_instrumentation_stack] ||= [])
+          if tp.event == :c_call
+            stack << Process.clock_gettime(Process::CLOCK_MONOTONIC)
+          elsif (start = stack.pop)
+            time = Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+            call = calls[name]
+            call[:count] += 1
+            call[:time] += time
+            if stack.empty?
+              @native_time = (@native_time || 0.0) + time
+              # phases are recorded natively and published once the outermost
+              # native call returns, so subscribers never run during a solve
+              publish_events
+            end
+          end
+        end
+      end
+
+      # skips ORTools module functions, which are only versions and instrumentation
+      def method_name(klass, method_id)
+        if klass.singleton_class?
+          owner = klass.attached_object
+          return unless owner.is_a?(Module) && owner.name&.start_with?("ORTools::")
+          "#{owner.name}.#{method_id}"
+        elsif klass.name&.start_with?("ORTools::")
+          "#{klass.name}##{method_id}"
+        end
+      end
+    end
+  end
+
+  def self.instrument
+    Instrumentation.enable
+    yield
+  ensure
+    Instrumentation.disable
+  end
+
+  def self.stats
+    Instrumentation.stats
+  end
+
+  def self.reset_stats
+    Instrumentation.reset
+  end
+
+  def self.subscribe(...)
+    Instrumentation.subscribe(...)
+  end
+
+  def self.unsubscribe(subscriber)
+    Instrumentation.unsubscribe(subscriber)
+  end
+end
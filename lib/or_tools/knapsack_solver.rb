@@ -5,6 +5,10 @@ module ORTools
       super(*args)
     end
 
+    def self.solve_batch(instances, solver_type: :auto, threads: nil)
+      _solve_batch(instances, solver_type, threads || 0)
+    end
+
     def solve(*args)
       return _solve if args.empty?
 
@@ -12,20 +16,12 @@ module ORTools
       init(values, weights, capacities)
       computed_value = _solve
 
-      packed_items = []
-      packed_weights = []
-      total_weight = 0
-      values.length.times do |i|
-        if best_solution_contains?(i)
-          packed_items << i
-          packed_weights << weights[0][i]
-          total_weight += weights[0][i]
-        end
-      end
+      packed_items = _best_solution_items(values.length)
+      packed_weights = packed_items.map { |i| weights[0][i] }
 
       {
         total_value: computed_value,
-        total_weight: total_weight,
+        total_weight: packed_weights.sum,
         packed_items: packed_items,
         packed_weights: packed_weights
       }
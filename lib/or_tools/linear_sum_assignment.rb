@@ -0,0 +1,7 @@
+module ORTools
+  class LinearSumAssignment
+    def self.solve_batch(instances, threads: nil)
+      _solve_batch(instances, threads || 0)
+    end
+  end
+end
@@ -0,0 +1,17 @@
+module ORTools
+  module MathOpt
+    class IncrementalSolver
+      def self.new(model, solver_type = :glop)
+        solver = _new(model, solver_type)
+        # the native solver keeps a pointer to the model
+        solver.instance_variable_set(:@model, model)
+        solver
+      end
+
+      def solve(parameters: nil, log: nil, **options)
+        parameters ||= SolveParameters.new(**options)
+        _solve(parameters, log)
+      end
+    end
+  end
+end
@@ -19,7 +19,57 @@ module ORTools
         else
           raise ArgumentError, "Supported operations are ==, <=, and >="
         end
-        nil
+        constraint
+      end
+
+      def add_quadratic_constraint(expr)
+        left, op, const = Utils.index_constraint(expr, check_linear: false)
+
+        case op
+        when :<=
+          _add_quadratic_constraint(left, -Float::INFINITY, const)
+        when :>=
+          _add_quadratic_constraint(left, const, Float::INFINITY)
+        when :==
+          _add_quadratic_constraint(left, const, const)
+        else
+          raise ArgumentError, "Supported operations are ==, <=, and >="
+        end
+      end
+
+      # ||arguments_to_norm||_2 <= upper_bound
+      def add_second_order_cone_constraint(arguments_to_norm, upper_bound)
+        arguments_to_norm = arguments_to_norm.map { |v| Utils.index_expression(Expression.to_expression(v), check_linear: true) }
+        upper_bound = Utils.index_expression(Expression.to_expression(upper_bound), check_linear: true)
+        _add_second_order_cone_constraint(arguments_to_norm, upper_bound)
+      end
+
+      def set_lower_bound(target, value)
+        if target.is_a?(Variable)
+          _set_variable_lower_bound(target, value)
+        else
+          _set_lower_bound(target, value)
+        end
+      end
+
+      def set_upper_bound(target, value)
+        if target.is_a?(Variable)
+          _set_variable_upper_bound(target, value)
+        else
+          _set_upper_bound(target, value)
+        end
+      end
+
+      def set_coefficient(constraint, var, value)
+        _set_coefficient(constraint, var, value)
+      end
+
+      def set_objective_coefficient(var, value)
+        _set_objective_coefficient(var, value)
+      end
+
+      def set_objective_quadratic_coefficient(first_var, second_var, value)
+        _set_objective_quadratic_coefficient(first_var, second_var, value)
       end
 
       def maximize(objective)
@@ -33,20 +83,31 @@ module ORTools
       end
 
       # TODO change default for MIP
-      def solve(solver_type = :glop)
-        _solve(solver_type)
+      def solve(solver_type = :glop, parameters: nil, log: nil, **options)
+        parameters ||= SolveParameters.new(**options)
+        _solve(solver_type, parameters, log)
       end
 
       private
 
       def set_objective(objective)
         objective = Expression.to_expression(objective)
-        coeffs = Utils.index_expression(objective, check_linear: true)
+        coeffs = Utils.index_expression(objective, check_linear: false)
         offset = coeffs.delete(nil)
 
-        objective.set_offset(offset) if offset
+        # quadratic keys are ordered by object, so combine x * y and y * x
+        quadratic = Hash.new(0)
         coeffs.each do |var, c|
-          _set_objective_coefficient(var, c)
+          quadratic[var.sort_by(&:id)] += c if var.is_a?(Array)
+        end
+
+        _clear_objective
+        _set_objective_offset(offset) if offset
+        coeffs.each do |var, c|
+          _set_objective_coefficient(var, c) unless var.is_a?(Array)
+        end
+        quadratic.each do |(first_var, second_var), c|
+          _set_objective_quadratic_coefficient(first_var, second_var, c)
         end
       end
     end
@@ -0,0 +1,15 @@
+module ORTools
+  module MathOpt
+    class SolveParameters
+      def self.new(**options)
+        parameters = super()
+        options.each do |k, v|
+          setter = "#{k}="
+          raise ArgumentError, "Unknown parameter: #{k}" unless parameters.respond_to?(setter)
+          parameters.send(setter, v)
+        end
+        parameters
+      end
+    end
+  end
+end
@@ -0,0 +1,37 @@
+module ORTools
+  class SatParameters
+    # merged over the current parameters, so presets can be combined with other settings
+    PRESETS = {
+      # stop at the first solution and skip expensive propagation
+      fast_feasibility: "stop_after_first_solution: true linearization_level: 0 cp_model_probing_level: 0 symmetry_level: 0",
+      # keep improving the best solution with neighborhood and local search
+      anytime: "linearization_level: 1 use_lns: true num_violation_ls: 1",
+      # stronger relaxations and symmetry breaking to close the gap
+      proof: "linearization_level: 2 symmetry_level: 3 cp_model_probing_level: 2",
+      # each worker has its own copy of the model
+      low_memory: "num_workers: 1 symmetry_level: 0"
+    }.freeze
+
+    def self.from_text(text)
+      parameters = new
+      parameters.merge_text(text)
+      parameters
+    end
+
+    def self.from_binary(data)
+      parameters = new
+      parameters.merge_binary(data)
+      parameters
+    end
+
+    def self.preset(name)
+      new.apply_preset(name)
+    end
+
+    def apply_preset(name)
+      text = PRESETS.fetch(name.to_sym) { raise ArgumentError, "Unknown preset: #{name}" }
+      merge_text(text)
+      self
+    end
+  end
+end
@@ -34,9 +34,24 @@ module ORTools
       objective.set_minimization
     end
 
-    def solve(parameters = nil)
+    # log captures stdout for the whole process during the solve,
+    # so it is only supported for backends that log there (CLP, CBC, and SCIP)
+    # and solves with log run one at a time
+    def solve(parameters = nil, log: nil)
       parameters ||= MPSolverParameters.new
-      _solve(parameters)
+
+      # no need to capture stdout
+      if log.is_a?(IO) && log.fileno == 1
+        output_enabled = output_enabled?
+        enable_output
+        begin
+          return _solve(parameters, nil)
+        ensure
+          suppress_output unless output_enabled
+        end
+      end
+
+      _solve(parameters, log)
     end
 
     private
@@ -1,10 +1,10 @@
 module ORTools
   module Utils
-    def self.index_constraint(constraint)
+    def self.index_constraint(constraint, check_linear: true)
       raise ArgumentError, "Expected Comparison" unless constraint.is_a?(Comparison)
 
-      left = index_expression(constraint.left, check_linear: true)
-      right = index_expression(constraint.right, check_linear: true)
+      left = index_expression(constraint.left, check_linear: check_linear)
+      right = index_expression(constraint.right, check_linear: check_linear)
 
       const = right.delete(nil).to_f - left.delete(nil).to_f
       right.each do |k, v|
@@ -27,7 +27,7 @@ module ORTools
         if check_linear && expression.left.vars.any? && expression.right.vars.any?
           raise ArgumentError, "Nonlinear"
         end
-        vars = index_product(expression.left, expression.right)
+        vars = index_product(expression.left, expression.right, check_linear: check_linear)
       when Expression
         expression.parts.each do |part|
           index_expression(part, check_linear: check_linear).each do |k, v|
@@ -40,7 +40,7 @@ module ORTools
       vars
     end
 
-    def self.index_product(left, right)
+    def self.index_product(left, right, check_linear: true)
       # normalize
       types = [Constant, Variable, Product, Expression]
       if types.index { |t| left.is_a?(t) } > types.index { |t| right.is_a?(t) }
@@ -50,14 +50,14 @@ module ORTools
       vars = Hash.new(0)
       case left
       when Constant
-        vars = index_expression(right)
+        vars = index_expression(right, check_linear: check_linear)
         vars.transform_values! { |v| v * left.value }
       when Variable
         case right
         when Variable
           vars[quad_key(left, right)] = 1
         when Product
-          index_expression(right).each do |k, v|
+          index_expression(right, check_linear: check_linear).each do |k, v|
             case k
             when Array
               raise Error, "Non-quadratic"
@@ -69,14 +69,14 @@ module ORTools
           end
         else
           right.parts.each do |part|
-            index_product(left, part).each do |k, v|
+            index_product(left, part, check_linear: check_linear).each do |k, v|
               vars[k] += v
             end
           end
         end
       when Product
-        index_expression(left).each do |lk, lv|
-          index_expression(right).each do |rk, rv|
+        index_expression(left, check_linear: check_linear).each do |lk, lv|
+          index_expression(right, check_linear: check_linear).each do |rk, rv|
             if lk.is_a?(Variable) && rk.is_a?(Variable)
               vars[quad_key(lk, rk)] = lv * rv
             else
@@ -87,7 +87,7 @@ module ORTools
       else # Expression
         left.parts.each do |lp|
           right.parts.each do |rp|
-            index_product(lp, rp).each do |k, v|
+            index_product(lp, rp, check_linear: check_linear).each do |k, v|
               vars[k] += v
             end
           end
@@ -195,4 +195,85 @@ class AssignmentTest < Minitest::Test
       Worker 3 assigned to task 0. Cost = 45
     EOS
   end
+
+  def test_linear_sum_assignment_bulk
+    assignment = ORTools::LinearSumAssignment.new
+    assignment.add_arcs_with_cost(
+      [0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3],
+      [0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3],
+      [90, 76, 75, 70, 35, 85, 55, 65, 125, 95, 90, 105, 45, 110, 95, 115]
+    )
+    assert_equal :optimal, assignment.solve
+    assert_equal 265, assignment.optimal_cost
+    assert_equal [3, 2, 1, 0], assignment.right_mates
+    assert_equal [70, 55, 95, 45], assignment.assignment_costs
+  end
+
+  def test_linear_sum_assignment_bulk_invalid_node
+    assignment = ORTools::LinearSumAssignment.new
+    error = assert_raises(ArgumentError) do
+      assignment.add_arcs_with_cost([0, 1, -1], [0, 1, 0], [1, 2, 3])
+    end
+    assert_equal "Invalid node", error.message
+    assert_equal 0, assignment.num_arcs
+  end
+
+  def test_linear_sum_assignment_batch
+    left_nodes = [0, 0, 1, 1]
+    right_nodes = [0, 1, 0, 1]
+    instances = [
+      [left_nodes, right_nodes, [1, 2, 3, 4]],
+      [left_nodes.pack("l*"), right_nodes.pack("l*"), [5, 1, 1, 5].pack("q*")],
+      [[0], [0], [1]],
+      [[0, 1], [0, 0], [1, 1]]
+    ]
+    results = ORTools::LinearSumAssignment.solve_batch(instances, threads: 2)
+    assert_equal 4, results.size
+    assert_equal({status: :optimal, optimal_cost: 5, right_mates: [0, 1]}, results[0])
+    assert_equal({status: :optimal, optimal_cost: 2, right_mates: [1, 0]}, results[1])
+    assert_equal({status: :optimal, optimal_cost: 1, right_mates: [0]}, results[2])
+    assert_equal :infeasible, results[3][:status]
+    assert_nil results[3][:right_mates]
+  end
+
+  def test_linear_sum_assignment_batch_invalid_node
+    instances = [
+      [[0, 1], [0, 1], [1, 1]],
+      [[0, 1], [0, -1], [1, 1]]
+    ]
+    error = assert_raises(ArgumentError) do
+      ORTools::LinearSumAssignment.solve_batch(instances, threads: 2)
+    end
+    assert_equal "Invalid node", error.message
+  end
+
+  def test_linear_sum_assignment_dense
+    costs = [
+      90, 76, 75, 70,
+      35, 85, 55, 65,
+      125, 95, 90, 105,
+      45, 110, 95, 115
+    ]
+    result = ORTools::LinearSumAssignment.solve_dense(costs.pack("q*"), 4, 4)
+    assert_equal({status: :optimal, optimal_cost: 265, right_mates: [3, 2, 1, 0]}, result)
+  end
+
+  def test_linear_sum_assignment_dense_rectangular
+    costs = [
+      90, 80, 75, 70,
+      35, nil, 55, 65
+    ]
+    result = ORTools::LinearSumAssignment.solve_dense(costs, 2, 4)
+    assert_equal({status: :optimal, optimal_cost: 105, right_mates: [3, 0]}, result)
+
+    result = ORTools::LinearSumAssignment.solve_dense([1, 2, 3], 3, 1)
+    assert_equal({status: :optimal, optimal_cost: 1, right_mates: [0, nil, nil]}, result)
+
+    result = ORTools::LinearSumAssignment.solve_dense([1, nil, 2, nil], 2, 2)
+    assert_equal :infeasible, result[:status]
+
+    assert_raises(ArgumentError) do
+      ORTools::LinearSumAssignment.solve_dense([1, 2, 3], 2, 2)
+    end
+  end
 end
@@ -64,6 +64,58 @@ class BinPackingTest < Minitest::Test
     assert_equal expected_weights, packed_weights
   end
 
+  def test_knapsack_solver_types
+    values = [360, 83, 59, 130, 431, 67, 230, 52, 93, 125]
+    weights = [[7, 0, 30, 22, 80, 94, 11, 81, 70, 64]]
+    capacities = [200]
+
+    [:branch_and_bound, :brute_force, :items_64, :dynamic_programming, :divide_and_conquer, :cbc_mip, :scip_mip, :cp_sat].each do |solver_type|
+      solver = ORTools::KnapsackSolver.new(solver_type, "KnapsackExample")
+      assert_equal 1359, solver.solve(values, weights, capacities)[:total_value], solver_type
+      assert_equal solver_type, solver.solver_type
+    end
+  end
+
+  def test_knapsack_auto
+    solver = ORTools::KnapsackSolver.new(:auto, "KnapsackExample")
+    assert_nil solver.solver_type
+    solver.set_time_limit(10)
+    solver.set_use_reduction(false)
+    refute solver.use_reduction
+
+    solver.init([1, 2, 3], [[1, 1, 1]], [2])
+    assert_equal 5, solver.solve
+    assert_equal :items_64, solver.solver_type
+    assert solver.solution_optimal?
+
+    solver.init([1] * 100, [[1] * 100], [50])
+    assert_equal 50, solver.solve
+    assert_equal :dynamic_programming, solver.solver_type
+
+    solver.init([1] * 100, [[1] * 100, [2] * 100], [50, 50])
+    assert_equal 25, solver.solve
+    assert_equal :branch_and_bound, solver.solver_type
+  end
+
+  def test_knapsack_invalid_dimensions
+    solver = ORTools::KnapsackSolver.new(:dynamic_programming, "KnapsackExample")
+    error = assert_raises(ArgumentError) do
+      solver.init([1, 2], [[1, 1], [1, 1]], [1, 1])
+    end
+    assert_equal "Solver only supports one dimension", error.message
+  end
+
+  def test_knapsack_batch
+    instances = [
+      [[360, 83, 59, 130], [[7, 0, 30, 22]], [30]],
+      [[1, 2, 3].pack("q*"), [1, 1, 1, 2, 2, 2].pack("q*"), [2, 3].pack("q*")],
+      [[5], [[10]], [5]]
+    ]
+    results = ORTools::KnapsackSolver.solve_batch(instances, threads: 2)
+    assert_equal [573, 3, 0], results.map { |r| r[:total_value] }
+    assert_equal ["11010000", "00100000", "00000000"], results.map { |r| r[:selection].unpack1("b*") }
+  end
+
   # https://developers.google.com/optimization/bin/multiple_knapsack
   def test_multiple_knapsack
     # create the data
@@ -205,4 +257,41 @@ class BinPackingTest < Minitest::Test
     assert_equal [87, 90, 97, 96], bin_weights
     assert_equal 4, num_bins
   end
+
+  def test_bin_packer
+    weights = [48, 30, 19, 36, 36, 27, 42, 42, 36, 24, 30]
+    packer = ORTools::BinPacker.new(weights, [100] * weights.size)
+    result = packer.solve(time_limit: 10)
+    assert_equal :optimal, result[:status]
+    assert_equal 4, result[:num_bins]
+    assert_equal 4, result[:lower_bound]
+    result[:assignments].each_with_index.group_by(&:first).each_value do |items|
+      assert_operator items.sum { |_, i| weights[i] }, :<=, 100
+    end
+  end
+
+  def test_bin_packer_multiple_dimensions
+    sizes = [[6, 1], [6, 1], [1, 6], [1, 6], [2, 2]]
+    packer = ORTools::BinPacker.new(sizes, [[10, 10]] * 5)
+    result = packer.solve
+    assert_equal :optimal, result[:status]
+    assert_equal 2, result[:num_bins]
+  end
+
+  def test_bin_packer_multiple_knapsack
+    weights = [48, 30, 42, 36, 36, 48, 42, 42, 36, 24, 30, 30, 42, 36, 36]
+    values = [10, 30, 25, 50, 35, 30, 15, 40, 30, 35, 45, 10, 20, 30, 25]
+    packer = ORTools::BinPacker.new(weights.pack("q*"), [100] * 5, values: values)
+    result = packer.solve(time_limit: 10)
+    assert_equal :optimal, result[:status]
+    assert_equal 395, result[:total_value]
+  end
+
+  def test_bin_packer_infeasible
+    packer = ORTools::BinPacker.new([60, 60, 60], [100, 100])
+    assert_equal :infeasible, packer.solve[:status]
+
+    packer = ORTools::BinPacker.new([101], [100])
+    assert_equal :infeasible, packer.solve[:status]
+  end
 end
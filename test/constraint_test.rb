@@ -220,6 +220,47 @@ class ConstraintTest < Minitest::Test
     assert_equal 92, solution_printer.solution_count
   end
 
+  def test_solution_pool
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 2, "x")
+    y = model.new_int_var(0, 2, "y")
+    z = model.new_bool_var("z")
+    model.add(x != y)
+    model.add(z == 1)
+
+    solver = ORTools::CpSolver.new
+    solver.parameters.enumerate_all_solutions = true
+
+    pool = ORTools::CpSolutionPool.new([x, y, z.not])
+    assert_equal :optimal, solver.solve(model, pool)
+    assert_equal 6, pool.size
+    assert_equal 3, pool.num_vars
+    expected = [[0, 1, 0], [0, 2, 0], [1, 0, 0], [1, 2, 0], [2, 0, 0], [2, 1, 0]]
+    assert_equal expected, pool.to_a.sort
+    assert_equal expected, pool.to_binary.unpack("q*").each_slice(3).sort
+    assert_nil solver.stop_reason
+
+    assert_equal 4, pool.shift(4).size
+    assert_equal 2, pool.size
+    assert_equal 6, pool.num_solutions
+
+    pool = ORTools::CpSolutionPool.new([x], unique: true)
+    solver.solve(model, pool)
+    assert_equal [[0], [1], [2]], pool.sort
+
+    pool = ORTools::CpSolutionPool.new([x, y], limit: 2)
+    solver.solve(model, pool)
+    assert_equal 2, pool.size
+    assert_equal :solution_limit, solver.stop_reason
+
+    other = ORTools::CpModel.new
+    5.times { other.new_bool_var("") }
+    error = assert_raises(ArgumentError) do
+      solver.solve(model, ORTools::CpSolutionPool.new([other.get_int_var_from_proto_index(4)]))
+    end
+    assert_equal "Variable not in model", error.message
+  end
+
   def test_time_limit
     model = ORTools::CpModel.new
     num_vals = 3
@@ -234,6 +275,401 @@ class ConstraintTest < Minitest::Test
     assert_equal :unknown, status
   end
 
+  def test_cumulative
+    model = ORTools::CpModel.new
+    horizon = 10
+    starts = 3.times.map { |i| model.new_int_var(0, horizon, "start#{i}") }
+    intervals = starts.map { |start| model.new_fixed_size_interval_var(start, 2, "") }
+    model.add_cumulative(intervals, [2, 2, 1], 3)
+    makespan = model.new_int_var(0, horizon, "makespan")
+    model.add_max_equality(makespan, starts.map { |start| start + 2 })
+    model.minimize(makespan)
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal 4, solver.value(makespan)
+  end
+
+  def test_no_overlap_2d
+    [[3, :infeasible], [4, :optimal]].each do |width, expected|
+      model = ORTools::CpModel.new
+      x_intervals = 2.times.map { model.new_fixed_size_interval_var(model.new_int_var(0, width - 2, ""), 2, "") }
+      y_intervals = 2.times.map { model.new_fixed_size_interval_var(model.new_int_var(0, 0, ""), 2, "") }
+      model.add_no_overlap_2d(x_intervals, y_intervals)
+
+      solver = ORTools::CpSolver.new
+      assert_equal expected, solver.solve(model)
+    end
+  end
+
+  def test_circuit
+    model = ORTools::CpModel.new
+    costs = [[0, 1, 5], [1, 0, 2], [5, 2, 0]]
+    arcs = []
+    literals = {}
+    3.times do |i|
+      3.times do |j|
+        next if i == j
+        literals[[i, j]] = model.new_bool_var("")
+        arcs << [i, j, literals[[i, j]]]
+      end
+    end
+    model.add_circuit(arcs)
+    model.minimize(model.sum(literals.map { |(i, j), v| v * costs[i][j] }))
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal 8, solver.objective_value
+    assert_equal 3, literals.values.count { |v| solver.value(v) }
+  end
+
+  def test_element
+    model = ORTools::CpModel.new
+    index = model.new_int_var(0, 3, "index")
+    target = model.new_int_var(0, 10, "target")
+    model.add_element(index, [5, 3, 8, 1], target)
+    model.maximize(target)
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal 2, solver.value(index)
+    assert_equal 8, solver.value(target)
+  end
+
+  def test_exactly_one
+    model = ORTools::CpModel.new
+    x = 3.times.map { model.new_bool_var("") }
+    y = 3.times.map { model.new_bool_var("") }
+    model.add_exactly_one(x)
+    model.add_at_most_one(y)
+    model.add_at_least_one([x[0], y[0]])
+    model.maximize(model.sum(x + y))
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal 2, solver.objective_value
+    assert_equal 1, x.count { |v| solver.value(v) }
+  end
+
+  def test_automaton
+    model = ORTools::CpModel.new
+    x = 5.times.map { model.new_int_var(0, 1, "") }
+    # no two consecutive ones
+    model.add_automaton(x, 0, [0, 1], [[0, 0, 0], [0, 1, 1], [1, 0, 0]])
+    model.maximize(model.sum(x))
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal [1, 0, 1, 0, 1], x.map { |v| solver.value(v) }
+  end
+
+  def test_reservoir
+    model = ORTools::CpModel.new
+    fill = model.new_int_var(0, 10, "fill")
+    drain = model.new_int_var(0, 10, "drain")
+    model.add_reservoir_constraint([fill, drain], [5, -5], 0, 5)
+    model.minimize(drain)
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_operator solver.value(fill), :<=, solver.value(drain)
+
+    active = model.new_bool_var("active")
+    model.add_reservoir_constraint_with_active([fill, drain], [5, -5], [active, active], 0, 5)
+    assert_equal :optimal, solver.solve(model)
+  end
+
+  def test_binary
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 10, "x")
+    y = model.new_bool_var("y")
+    model.new_interval_var(x, model.new_constant(2), model.new_int_var(0, 12, "end"), "interval")
+    model.add(x + y * 5 <= 12)
+    model.maximize(x + y * 2)
+
+    copy = ORTools::CpModel.from_binary(model.to_binary)
+    assert_equal model.to_s, copy.to_s
+    assert_equal model.num_variables, copy.num_variables
+    assert_equal model.num_constraints, copy.num_constraints
+
+    x2 = copy.find_int_var("x")
+    y2 = copy.find_bool_var("y")
+    assert_equal "x", x2.name
+    assert_equal "y", copy.get_bool_var_from_proto_index(y.index).name
+    assert_equal "interval", copy.get_interval_var_from_proto_index(0).name
+    assert_nil copy.find_int_var("missing")
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(copy)
+    assert_equal 10, solver.value(x2)
+    assert_equal false, solver.value(y2)
+
+    assert_raises(ArgumentError) do
+      copy.get_bool_var_from_proto_index(x2.index)
+    end
+    assert_raises(IndexError) do
+      copy.get_int_var_from_proto_index(100)
+    end
+    assert_raises(ArgumentError) do
+      ORTools::CpModel.from_binary("invalid")
+    end
+  end
+
+  def test_load_file
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 10, "x")
+    model.add(x >= 3)
+    model.minimize(x)
+
+    Dir.mktmpdir do |dir|
+      ["model.pb", "model.pb.txt"].each do |filename|
+        path = File.join(dir, filename)
+        assert model.export_to_file(path)
+
+        copy = ORTools::CpModel.load_file(path)
+        assert_equal model.to_s, copy.to_s
+
+        solver = ORTools::CpSolver.new
+        assert_equal :optimal, solver.solve(copy)
+        assert_equal 3, solver.value(copy.find_int_var("x"))
+      end
+
+      assert_raises(Errno::ENOENT) do
+        ORTools::CpModel.load_file(File.join(dir, "missing.pb"))
+      end
+    end
+  end
+
+  def test_fork
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 10, "x")
+    y = model.new_int_var(0, 10, "y")
+    constraint = model.add(x + y <= 10)
+    model.maximize(x + y * 2)
+
+    tightened = model.fork
+    tightened.tighten_domain(y, 0, 4)
+    tightened.tighten_domain(y, ORTools::Domain.new(2, 8))
+    assert_equal 2, tightened.find_int_var("y").domain.min
+    assert_equal 4, tightened.find_int_var("y").domain.max
+
+    removed = model.dup
+    removed.remove_constraint(constraint)
+
+    extra = removed.fork
+    extra.add(x <= 7)
+    assert_raises(ArgumentError) do
+      extra.remove_constraint(model.add(x >= 0))
+    end
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal 20, solver.objective_value
+    assert_equal :optimal, solver.solve(tightened)
+    assert_equal 14, solver.objective_value
+    assert_equal 6, solver.value(x)
+    assert_equal :optimal, solver.solve(removed)
+    assert_equal 30, solver.objective_value
+    assert_equal :optimal, solver.solve(extra)
+    assert_equal 27, solver.objective_value
+
+    assert_raises(ArgumentError) do
+      tightened.tighten_domain(y, 5, 10)
+    end
+  end
+
+  def test_solve_many
+    models =
+      5.times.map do |i|
+        model = ORTools::CpModel.new
+        x = model.new_int_var(0, 10, "x")
+        y = model.new_int_var(0, 10, "y")
+        model.add(x + y <= i + 3)
+        model.maximize(x * 2 + y)
+        model
+      end
+
+    finished = []
+    responses = ORTools::CpSolver.solve_many(models, total_threads: 2, per_model_time_limit: 10) do |i, response|
+      finished << i
+      assert_equal :optimal, response.status
+    end
+    assert_equal [0, 1, 2, 3, 4], finished.sort
+    assert_equal [6, 8, 10, 12, 14], responses.map(&:objective_value)
+
+    error = assert_raises(RuntimeError) do
+      ORTools::CpSolver.solve_many(models) do
+        raise "Error!"
+      end
+    end
+    assert_equal "Error!", error.message
+  end
+
+  def test_solve_many_interrupt
+    # market split instances, which take much longer than the timeout
+    random = Random.new(1)
+    models =
+      2.times.map do
+        model = ORTools::CpModel.new
+        x = 40.times.map { |i| model.new_bool_var("x#{i}") }
+        4.times do
+          coefficients = x.map { random.rand(100) }
+          model.add(model.sum(x.zip(coefficients).map { |v, c| v * c }) == coefficients.sum / 2)
+        end
+        model
+      end
+
+    started_at = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    assert_raises(Timeout::Error) do
+      Timeout.timeout(0.5) do
+        ORTools::CpSolver.solve_many(models, total_threads: 2, per_model_time_limit: 60)
+      end
+    end
+    assert_operator Process.clock_gettime(Process::CLOCK_MONOTONIC) - started_at, :<, 10
+  end
+
+  def test_log_callback
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 10, "x")
+    y = model.new_int_var(0, 10, "y")
+    model.add(x + y <= 12)
+    model.maximize(x * 2 + y)
+
+    lines = []
+    solver = ORTools::CpSolver.new
+    solver.log_callback = ->(line) { lines << line }
+    assert_equal :optimal, solver.solve(model)
+    assert lines.any? { |line| line.start_with?("Starting CP-SAT") }
+
+    assert_equal 22, solver.best_objective_bound
+    assert_operator solver.deterministic_time, :>=, 0
+    assert_operator solver.user_time, :>=, 0
+    assert_operator solver.num_booleans, :>=, 0
+    assert_match "CpSolverResponse", solver.response_stats
+
+    progress = solver.progress
+    assert_operator progress[:num_solutions], :>=, 1
+    assert_equal 22, progress[:objective]
+    assert_equal 0, progress[:dropped_log_messages]
+    assert_equal progress[:num_solutions], progress[:subsolvers].values.sum { |v| v[:num_solutions] }
+
+    solver.log_callback = ->(line) { raise "Error!" }
+    error = assert_raises(RuntimeError) do
+      solver.solve(model)
+    end
+    assert_equal "Error!", error.message
+  end
+
+  def test_solution_callback_queue
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 20, "x")
+    y = model.new_int_var(0, 20, "y")
+    model.add(x + y >= 0)
+
+    # more solutions than can be queued, so the solver waits for the callback
+    solver = ORTools::CpSolver.new
+    solver.parameters.enumerate_all_solutions = true
+    solver.log_callback = ->(line) {}
+    solution_printer = VarArraySolutionPrinter.new([x, y])
+    assert_equal :optimal, solver.solve(model, solution_printer)
+    assert_equal 441, solution_printer.solution_count
+    assert_equal 441, solver.progress[:num_solutions]
+  end
+
+  def test_stop_rules
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 100, "x")
+    y = model.new_int_var(0, 100, "y")
+    model.add(x + y * 2 <= 150)
+    model.maximize(x + y)
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_nil solver.stop_reason
+
+    status = solver.solve(model, target_objective: 10)
+    assert_includes [:feasible, :optimal], status
+    assert_equal :target_objective, solver.stop_reason
+    assert_operator solver.objective_value, :>=, 10
+    assert_equal :target_objective, solver.progress[:stop_reason]
+
+    status = solver.solve(model, absolute_gap: 1000)
+    assert_includes [:feasible, :optimal], status
+    assert_equal :absolute_gap, solver.stop_reason
+
+    assert_equal :optimal, solver.solve(model, relative_gap: 0, no_improvement_time: 60)
+    assert_equal 125, solver.objective_value
+  end
+
+  def test_parameters
+    parameters = ORTools::SatParameters.new
+    parameters.relative_gap_limit = 0.01
+    parameters["subsolvers"] = ["default_lns", "fixed"]
+    parameters["search_branching"] = :fixed_search
+    parameters["max_presolve_iterations"] = 2
+    parameters.merge_text("log_search_progress: false symmetry_level: 1")
+
+    assert_equal 0.01, parameters.relative_gap_limit
+    assert_equal ["default_lns", "fixed"], parameters["subsolvers"]
+    assert_equal :fixed_search, parameters["search_branching"]
+    assert_equal 2, parameters["max_presolve_iterations"]
+    assert_equal 1, parameters.symmetry_level
+
+    copy = ORTools::SatParameters.from_binary(parameters.to_binary)
+    assert_equal parameters.to_text, copy.to_text
+    assert_equal ORTools::SatParameters.from_text(parameters.to_text).to_binary, parameters.to_binary
+
+    parameters["subsolvers"] = nil
+    assert_empty parameters["subsolvers"]
+
+    error = assert_raises(ArgumentError) do
+      parameters["missing"] = 1
+    end
+    assert_equal "Unknown parameter: missing", error.message
+
+    assert_raises(ArgumentError) do
+      parameters["search_branching"] = :missing
+    end
+
+    # repeated fields are unchanged if any element is invalid
+    parameters["restart_algorithms"] = [:luby_restart]
+    assert_raises(ArgumentError) do
+      parameters["restart_algorithms"] = [:dl_moving_average_restart, :missing]
+    end
+    assert_equal [:luby_restart], parameters["restart_algorithms"]
+
+    assert_raises(ArgumentError) do
+      parameters.merge_text("missing: 1")
+    end
+  end
+
+  def test_parameters_presets
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 10, "x")
+    y = model.new_int_var(0, 10, "y")
+    model.add(x + y <= 12)
+    model.maximize(x * 2 + y)
+
+    ORTools::SatParameters::PRESETS.each_key do |name|
+      solver = ORTools::CpSolver.new
+      solver.parameters = ORTools::SatParameters.preset(name)
+      status = solver.solve(model)
+      if name == :fast_feasibility
+        assert_includes [:feasible, :optimal], status
+      else
+        assert_equal :optimal, status
+        assert_equal 22, solver.objective_value
+      end
+    end
+
+    assert_equal 1, ORTools::SatParameters.preset(:low_memory).num_workers
+
+    error = assert_raises(ArgumentError) do
+      ORTools::SatParameters.preset(:missing)
+    end
+    assert_equal "Unknown preset: missing", error.message
+  end
+
   def test_infeasible_value
     model = ORTools::CpModel.new
 
@@ -265,6 +701,42 @@ class ConstraintTest < Minitest::Test
     assert_equal "The Ruby object does not wrap a C++ object. It is actually a String.", error.message
   end
 
+  def test_add_hints
+    model = ORTools::CpModel.new
+    x = model.new_int_var(0, 10, "x")
+    y = model.new_int_var(0, 10, "y")
+    z = model.new_bool_var("z")
+    model.add(x + y <= 12)
+    model.maximize(x * 2 + y + z)
+
+    model.add_hints([x, y, z], [3, 4, 1])
+    assert_equal 3, model.num_hints
+    model.clear_hints
+    model.add_hints([0, 1].pack("l*"), [2, 2].pack("q*"))
+    assert_equal 2, model.num_hints
+    model.clear_hints
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+
+    copy = model.fork
+    copy.add_hints_from_response(solver.response)
+    assert_equal model.num_variables, copy.num_hints
+
+    # fixing to the hint keeps the previous solution
+    solver.parameters.fix_variables_to_their_hinted_value = true
+    assert_equal :optimal, solver.solve(copy)
+    assert_equal 23, solver.objective_value
+    assert_equal [10, 2, true], [solver.value(x), solver.value(y), solver.value(z)]
+
+    assert_raises(ArgumentError) do
+      model.add_hints([x, y], [1])
+    end
+    assert_raises(IndexError) do
+      model.add_hints([100], [1])
+    end
+  end
+
   def test_int_var_domain
     model = ORTools::CpModel.new
 
@@ -318,4 +790,48 @@ class ConstraintTest < Minitest::Test
     assert_equal 1, domain.min
     assert_equal 3, domain.max
   end
+
+  def test_domain_operations
+    domain = ORTools::Domain.from_intervals([[1, 3], [6, 8]])
+    assert_equal [1, 3, 6, 8], domain.flattened_intervals
+    assert_equal 6, domain.size
+    assert domain.contains?(7)
+    refute domain.contains?(5)
+    assert_equal "[1,3][6,8]", domain.to_s
+    assert_equal domain, ORTools::Domain.from_flat_intervals([1, 3, 6, 8])
+
+    assert_equal [4, 5], domain.complement.intersection_with(ORTools::Domain.new(1, 8)).flattened_intervals
+    assert_equal [1, 8], domain.union_with(ORTools::Domain.new(4, 5)).flattened_intervals
+    assert_equal [-8, -6, -3, -1], domain.negation.flattened_intervals
+    assert_equal [11, 13, 16, 18], domain.addition_with(ORTools::Domain.new(10, 10)).flattened_intervals
+    assert ORTools::Domain.new(2, 3).included_in?(domain)
+    assert ORTools::Domain.new(4, 5).intersection_with(domain).empty?
+    assert ORTools::Domain.from_values([5]).fixed?
+    assert_equal 5, ORTools::Domain.greater_or_equal(5).min
+    assert_equal 5, ORTools::Domain.lower_or_equal(5).max
+
+    assert_raises(ArgumentError) do
+      ORTools::Domain.from_flat_intervals([1, 2, 3])
+    end
+  end
+
+  def test_new_int_var_from_domain
+    model = ORTools::CpModel.new
+    x = model.new_int_var_from_domain(ORTools::Domain.from_values([1, 4, 9]), "x")
+    y = model.new_int_var(0, 10, "y")
+    b = model.new_bool_var("b")
+    model.add_linear_expression_in_domain(x + y, ORTools::Domain.from_intervals([[0, 5], [12, 20]]), b)
+    model.add(b == 1)
+    model.maximize(x + y)
+
+    solver = ORTools::CpSolver.new
+    assert_equal :optimal, solver.solve(model)
+    assert_equal 9, solver.value(x)
+    assert_equal 19, solver.objective_value
+    assert_equal [1, 1, 4, 4, 9, 9], x.domain.flattened_intervals
+
+    assert_raises(ArgumentError) do
+      model.new_int_var_from_domain(ORTools::Domain.from_values([]), "z")
+    end
+  end
 end
@@ -107,6 +107,76 @@ class LinearTest < Minitest::Test
     assert_equal "Unrecognized solver type", error.message
   end
 
+  def test_num_threads
+    solver = ORTools::Solver.new("SCIP")
+    solver.num_threads = 2
+    assert_equal 2, solver.num_threads
+
+    error = assert_raises(ArgumentError) do
+      solver.num_threads = 0
+    end
+    assert_match "num_threads", error.message
+  end
+
+  def test_solver_specific_parameters
+    solver = ORTools::Solver.new("GLOP")
+    solver.solver_specific_parameters = "use_dual_simplex: true"
+    assert_equal "use_dual_simplex: true", solver.solver_specific_parameters
+
+    x = solver.num_var(0, 1, "x")
+    solver.maximize(x)
+    assert_equal :optimal, solver.solve
+
+    error = assert_raises(ArgumentError) do
+      solver.solver_specific_parameters = "bad"
+    end
+    assert_equal "Invalid solver specific parameters", error.message
+  end
+
+  def test_log
+    solver = ORTools::Solver.new("CBC")
+    x = solver.int_var(0, 10, "x")
+    y = solver.int_var(0, 10, "y")
+    solver.add(2 * x + 3 * y <= 12)
+    solver.maximize(x + y)
+
+    log = StringIO.new
+    assert_equal :optimal, solver.solve(log: log)
+    assert_equal 6, solver.objective.value
+    refute_empty log.string
+  end
+
+  def test_log_stdout
+    solver = ORTools::Solver.new("CBC")
+    x = solver.int_var(0, 10, "x")
+    y = solver.int_var(0, 10, "y")
+    solver.add(2 * x + 3 * y <= 12)
+    solver.maximize(x + y)
+
+    # CBC writes to the stdout file descriptor
+    out, _ = capture_subprocess_io do
+      assert_equal :optimal, solver.solve(log: $stdout)
+    end
+    refute_empty out
+    refute solver.output_enabled?
+
+    out, _ = capture_subprocess_io do
+      assert_equal :optimal, solver.solve
+    end
+    assert_empty out
+  end
+
+  def test_log_unsupported
+    solver = ORTools::Solver.new("GLOP")
+    x = solver.num_var(0, 10, "x")
+    solver.maximize(x)
+
+    error = assert_raises(ArgumentError) do
+      solver.solve(log: StringIO.new)
+    end
+    assert_equal "log is only supported for CLP, CBC, and SCIP", error.message
+  end
+
   def test_relative_mip_gap_parameter
     params = ORTools::MPSolverParameters.new
     assert_equal 1e-4, params.relative_mip_gap
@@ -23,6 +23,22 @@ class MathOptTest < Minitest::Test
     EOS
   end
 
+  def test_dense_arrays
+    model = ORTools::MathOpt::Model.new("getting_started_lp")
+    x = model.add_variable(-1.0, 1.5, "x")
+    y = model.add_variable(0.0, 1.0, "y")
+    model.add_linear_constraint(x + y <= 1.5)
+    model.maximize(x + 2 * y)
+
+    result = model.solve
+    assert_equal [0, 1], [x.id, y.id]
+    assert_equal [0.5, 1.0], result.variable_values_array
+    assert_equal [0.0, 1.0], result.reduced_costs_array
+    assert_equal [1.0], result.dual_values_array
+    assert_equal [:basic, :at_upper_bound], result.variable_status_array
+    assert_equal [:at_upper_bound], result.constraint_status_array
+  end
+
   def test_minimize
     model = ORTools::MathOpt::Model.new("getting_started_lp")
     x = model.add_variable(-1.0, 1.5, "x")
@@ -75,6 +91,195 @@ class MathOptTest < Minitest::Test
     assert_equal "Glop does not support integer variables", error.message
   end
 
+  def test_incremental_solver
+    model = ORTools::MathOpt::Model.new("incremental")
+    x = model.add_variable(-1.0, 1.5, "x")
+    y = model.add_variable(0.0, 1.0, "y")
+    constraint = model.add_linear_constraint(x + y <= 1.5)
+    model.maximize(x + 2 * y)
+
+    solver = ORTools::MathOpt::IncrementalSolver.new(model, :glop)
+    result = solver.solve
+    assert_equal :optimal, result.termination.reason
+    assert_equal 2.5, result.objective_value
+
+    model.set_upper_bound(constraint, 1.0)
+    result = solver.solve
+    assert_equal 2, result.objective_value
+
+    model.set_upper_bound(y, 0.5)
+    result = solver.solve
+    assert_equal 1.5, result.objective_value
+    assert_equal 0.5, result.variable_values[x]
+    assert_equal 0.5, result.variable_values[y]
+
+    model.set_coefficient(constraint, y, 2)
+    model.set_objective_coefficient(x, 3)
+    result = solver.solve
+    assert_in_delta 3, result.objective_value
+    assert_in_delta 1, result.variable_values[x]
+  end
+
+  def test_objective_offset
+    model = ORTools::MathOpt::Model.new("offset")
+    x = model.add_variable(0.0, 1.0, "x")
+    model.maximize(x + 2)
+    assert_equal 3, model.solve.objective_value
+
+    model.minimize(x)
+    assert_equal 0, model.solve.objective_value
+  end
+
+  def test_quadratic_objective
+    model = ORTools::MathOpt::Model.new("qp")
+    x = model.add_variable(-10.0, 10.0, "x")
+    model.minimize((x - 1) * (x - 1))
+
+    result = model.solve(:pdlp)
+    assert_equal :optimal, result.termination.reason
+    assert_in_delta 1, result.variable_values[x], 1e-3
+    assert_in_delta 0, result.objective_value, 1e-3
+  end
+
+  def test_quadratic_constraint
+    model = ORTools::MathOpt::Model.new("qcp")
+    x = model.add_variable(-10.0, 10.0, "x")
+    y = model.add_variable(-10.0, 10.0, "y")
+    model.add_quadratic_constraint(x * x + y * y <= 2)
+    model.maximize(x + y)
+
+    result = model.solve(:gscip)
+    assert_equal :optimal, result.termination.reason
+    assert_in_delta 2, result.objective_value, 1e-4
+  end
+
+  def test_scaled_quadratic_objective
+    model = ORTools::MathOpt::Model.new("portfolio")
+    w = 2.times.map { |i| model.add_variable(0.0, 1.0, "w#{i}") }
+    cov = [[0.1, 0.02], [0.02, 0.4]]
+    model.add_linear_constraint(w[0] + w[1] == 1)
+    model.minimize(2.times.sum { |i| 2.times.sum { |j| w[i] * w[j] * cov[i][j] } })
+
+    # PDLP only supports diagonal quadratic objectives
+    result = model.solve(:gscip)
+    assert_equal :optimal, result.termination.reason
+    assert_in_delta 0.826, result.variable_values[w[0]], 1e-3
+    assert_in_delta 0.0861, result.objective_value, 1e-3
+  end
+
+  def test_quadratic_objective_symmetric_terms
+    model = ORTools::MathOpt::Model.new("qp")
+    x = model.add_variable(0.0, 1.0, "x")
+    y = model.add_variable(0.0, 1.0, "y")
+    model.add_linear_constraint(x + y == 1)
+
+    # result keys are different objects for the same variables
+    x2, y2 = model.solve(:gscip).variable_values.keys.sort_by(&:id)
+
+    # x * y and y * x are the same term, so the objective is x^2 + y^2 - 4xy
+    model.minimize(x * x + y * y - 2 * (x * y2) - 2 * (y * x2))
+    result = model.solve(:gscip)
+    assert_equal :optimal, result.termination.reason
+    assert_in_delta 0.5, result.variable_values[x], 1e-4
+    assert_in_delta(-0.5, result.objective_value, 1e-4)
+
+    model.minimize(x * x + y * y - x * y - y * x)
+    result = model.solve(:gscip)
+    assert_in_delta 0, result.objective_value, 1e-4
+  end
+
+  def test_scaled_quadratic_constraint
+    model = ORTools::MathOpt::Model.new("qcp")
+    x = model.add_variable(-10.0, 10.0, "x")
+    y = model.add_variable(-10.0, 10.0, "y")
+    model.add_quadratic_constraint(2 * (x * x) + 2 * (y * y) <= 4)
+    model.maximize(x + y)
+
+    result = model.solve(:gscip)
+    assert_equal :optimal, result.termination.reason
+    assert_in_delta 2, result.objective_value, 1e-4
+  end
+
+  def test_second_order_cone_constraint
+    model = ORTools::MathOpt::Model.new("socp")
+    x = model.add_variable(-10.0, 10.0, "x")
+    y = model.add_variable(-10.0, 10.0, "y")
+    constraint = model.add_second_order_cone_constraint([x, 2 * y - 1], 2)
+    model.maximize(x + y)
+
+    # no bundled solver supports second-order cone constraints
+    assert_equal [{x => 1}, {y => 2, nil => -1}], constraint.arguments_to_norm
+    assert_equal({nil => 2}, constraint.upper_bound)
+
+    assert_raises(ArgumentError) do
+      model.solve(:glop)
+    end
+  end
+
+  def test_solve_parameters
+    params = ORTools::MathOpt::SolveParameters.new(time_limit: 10, threads: 2, relative_gap_tolerance: 0.01, presolve: :off)
+    assert_equal 10, params.time_limit
+    assert_equal 2, params.threads
+    assert_equal 0.01, params.relative_gap_tolerance
+    assert_equal :off, params.presolve
+    assert_nil params.cuts
+
+    params.time_limit = nil
+    assert_nil params.time_limit
+
+    params.cp_sat = "num_workers: 1"
+    assert_match "num_workers: 1", params.cp_sat
+
+    assert_raises(ArgumentError) do
+      params.cuts = :unknown
+    end
+
+    assert_raises(ArgumentError) do
+      params.glop = "unknown: 1"
+    end
+
+    error = assert_raises(ArgumentError) do
+      ORTools::MathOpt::SolveParameters.new(unknown: 1)
+    end
+    assert_equal "Unknown parameter: unknown", error.message
+  end
+
+  def test_solve_options
+    model = ORTools::MathOpt::Model.new("getting_started_lp")
+    x = model.add_integer_variable(1, 3, "x")
+    y = model.add_integer_variable(0, 5, "y")
+    model.add_linear_constraint(x + y >= 0)
+    model.maximize(x + 2 * y)
+
+    log = StringIO.new
+    result = model.solve(:cpsat, time_limit: 10, threads: 1, random_seed: 42, log: log)
+    assert_equal :optimal, result.termination.reason
+    assert_nil result.termination.limit
+    assert_equal 13, result.objective_value
+    refute_empty log.string
+  end
+
+  def test_interrupt
+    # market split instance, which takes CP-SAT much longer than the timeout
+    model = ORTools::MathOpt::Model.new("market_split")
+    random = Random.new(1)
+    x = 40.times.map { |i| model.add_binary_variable("x#{i}") }
+    4.times do
+      coefficients = x.map { random.rand(100) }
+      model.add_linear_constraint(x.zip(coefficients).map { |v, c| c * v }.sum == coefficients.sum / 2)
+    end
+
+    log = StringIO.new
+    started_at = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    assert_raises(Timeout::Error) do
+      Timeout.timeout(0.5) do
+        model.solve(:cpsat, time_limit: 60, threads: 1, log: log)
+      end
+    end
+    assert_operator Process.clock_gettime(Process::CLOCK_MONOTONIC) - started_at, :<, 10
+    refute_empty log.string
+  end
+
   def test_inspect
     model = ORTools::MathOpt::Model.new("getting_started_lp")
     x = model.add_integer_variable(-1.0, 1.5, "x")
@@ -93,4 +93,107 @@ class NetworkFlowsTest < Minitest::Test
     assert_equal [8, 7, 6, 5], arcs.map { |i| min_cost_flow.head(i) }
     assert_equal [70, 55, 95, 45], arcs.map { |i| min_cost_flow.unit_cost(i) }
   end
+
+  def test_max_flow_bulk
+    max_flow = ORTools::SimpleMaxFlow.new
+    max_flow.add_arcs_with_capacity([0, 0, 0, 1, 1, 2, 2, 3, 3], [1, 2, 3, 2, 4, 3, 4, 2, 4], [20, 30, 10, 40, 30, 10, 20, 5, 20])
+    assert_equal :optimal, max_flow.solve(0, 4)
+    assert_equal 60, max_flow.optimal_flow
+    assert_equal 9, max_flow.num_arcs
+    assert_equal [20, 30, 10, 0, 20, 10, 20, 0, 20], max_flow.flows.unpack("q*")
+    assert_equal [[0, 20], [1, 30], [2, 10], [4, 20], [5, 10], [6, 20], [8, 20]], max_flow.nonzero_flows
+  end
+
+  def test_min_cost_flow_bulk
+    min_cost_flow = ORTools::SimpleMinCostFlow.new(5, 9)
+    min_cost_flow.add_arcs_with_capacity_and_unit_cost(
+      [0, 0, 1, 1, 1, 2, 2, 3, 4].pack("l*"),
+      [1, 2, 2, 3, 4, 3, 4, 4, 2].pack("l*"),
+      [15, 8, 20, 4, 10, 15, 4, 20, 5].pack("q*"),
+      [4, 4, 2, 2, 6, 1, 3, 2, 3].pack("q*")
+    )
+    min_cost_flow.set_nodes_supplies([0, 1, 2, 3, 4], [20, 0, 0, -5, -15])
+    assert_equal :optimal, min_cost_flow.solve
+    assert_equal 150, min_cost_flow.optimal_cost
+    assert_equal [12, 8, 8, 4, 0, 12, 4, 11, 0], min_cost_flow.flows.unpack("q*")
+    assert_equal [[0, 12], [1, 8], [2, 8], [3, 4], [5, 12], [6, 4], [7, 11]], min_cost_flow.nonzero_flows
+  end
+
+  def test_bulk_different_sizes
+    min_cost_flow = ORTools::SimpleMinCostFlow.new
+    error = assert_raises(ArgumentError) do
+      min_cost_flow.add_arcs_with_capacity_and_unit_cost([0, 1], [1, 2], [1, 1], [1])
+    end
+    assert_equal "Expected same size, got 2 and 1", error.message
+
+    error = assert_raises(ArgumentError) do
+      min_cost_flow.set_nodes_supplies([0].pack("l*"), "\x00")
+    end
+    assert_equal "Invalid buffer size", error.message
+  end
+
+  def test_bulk_invalid_node
+    max_flow = ORTools::SimpleMaxFlow.new
+    error = assert_raises(ArgumentError) do
+      max_flow.add_arcs_with_capacity([0, 1], [1, -1], [1, 1])
+    end
+    assert_equal "Invalid node", error.message
+    assert_equal 0, max_flow.num_arcs
+
+    min_cost_flow = ORTools::SimpleMinCostFlow.new
+    error = assert_raises(ArgumentError) do
+      min_cost_flow.add_arcs_with_capacity_and_unit_cost([0, -1], [1, 2], [1, 1], [1, 1])
+    end
+    assert_equal "Invalid node", error.message
+    assert_equal 0, min_cost_flow.num_arcs
+  end
+
+  def test_max_flow_incremental
+    max_flow = ORTools::MaxFlow.new([0, 0, 0, 1, 1, 2, 2, 3, 3], [1, 2, 3, 2, 4, 3, 4, 2, 4], [20, 30, 10, 40, 30, 10, 20, 5, 20])
+    assert_equal 5, max_flow.num_nodes
+    assert_equal 9, max_flow.num_arcs
+
+    assert_equal :optimal, max_flow.solve(0, 4)
+    assert_equal 60, max_flow.optimal_flow
+    assert_equal [20, 30, 10, 0, 20, 10, 20, 0, 20], max_flow.flows.unpack("q*")
+    assert_equal [0], max_flow.source_side_min_cut
+
+    max_flow.set_arc_capacity(2, 0)
+    assert_equal 0, max_flow.capacity(2)
+    assert_equal :optimal, max_flow.solve(0, 4)
+    assert_equal 50, max_flow.optimal_flow
+
+    assert_raises(IndexError) do
+      max_flow.set_arc_capacity(9, 1)
+    end
+  end
+
+  def test_min_cost_flow_incremental
+    min_cost_flow = ORTools::MinCostFlow.new(
+      [0, 0, 1, 1, 1, 2, 2, 3, 4],
+      [1, 2, 2, 3, 4, 3, 4, 4, 2],
+      [15, 8, 20, 4, 10, 15, 4, 20, 5],
+      [4, 4, 2, 2, 6, 1, 3, 2, 3]
+    )
+    [20, 0, 0, -5, -15].each_with_index do |supply, i|
+      min_cost_flow.set_node_supply(i, supply)
+    end
+
+    assert_equal :optimal, min_cost_flow.solve
+    assert_equal 150, min_cost_flow.optimal_cost
+    assert_equal [12, 8, 8, 4, 0, 12, 4, 11, 0], min_cost_flow.flows.unpack("q*")
+
+    min_cost_flow.set_arc_unit_cost(5, 10)
+    assert_equal :optimal, min_cost_flow.solve
+    assert_equal 182, min_cost_flow.optimal_cost
+
+    min_cost_flow.set_arc_capacity(0, 12)
+    assert_equal :optimal, min_cost_flow.solve
+    assert_equal 194, min_cost_flow.optimal_cost
+    assert_equal 12, min_cost_flow.flow(0)
+
+    min_cost_flow.set_node_supply(0, 30)
+    min_cost_flow.set_node_supply(4, -25)
+    assert_equal :infeasible, min_cost_flow.solve
+  end
 end
@@ -4,4 +4,52 @@ class ORToolsTest < Minitest::Test
   def test_lib_version
     assert_match(/\A\d+\.\d+\.\d+\z/, ORTools.lib_version)
   end
+
+  def test_instrument
+    events = []
+    subscriber = ORTools.subscribe { |*args| events << args }
+    ORTools.reset_stats
+
+    max_flow = ORTools::SimpleMaxFlow.new
+    ORTools.instrument do
+      assert ORTools::Instrumentation.enabled?
+      max_flow.add_arcs_with_capacity([0, 0, 1], [1, 2, 2], [3, 2, 5])
+      assert_equal :optimal, max_flow.solve(0, 2)
+    end
+    refute ORTools::Instrumentation.enabled?
+
+    stats = ORTools.stats
+    assert_equal 1, stats[:calls]["ORTools::SimpleMaxFlow#solve"][:count]
+    assert_equal 1, stats[:phases]["solve.max_flow"][:count]
+    assert_equal 3, stats[:conversions]["buffer"][:count]
+    assert_operator stats[:gvl_released_time], :>, 0
+
+    assert_equal 1, events.size
+    name, start, finish, _, payload = events.first
+    assert_equal "solve.max_flow.or_tools", name
+    assert_operator start, :<=, finish
+    assert_equal({}, payload)
+
+    # no events or stats when disabled
+    max_flow.solve(0, 2)
+    assert_equal 1, events.size
+    assert_equal 1, ORTools.stats[:phases]["solve.max_flow"][:count]
+  ensure
+    ORTools.unsubscribe(subscriber)
+  end
+
+  def test_subscriber_error
+    subscriber = ORTools.subscribe { raise "Error!" }
+
+    max_flow = ORTools::SimpleMaxFlow.new
+    max_flow.add_arcs_with_capacity([0, 0, 1], [1, 2, 2], [3, 2, 5])
+    assert_output(nil, /Subscriber error: RuntimeError: Error!/) do
+      ORTools.instrument do
+        assert_equal :optimal, max_flow.solve(0, 2)
+      end
+    end
+    assert_equal 5, max_flow.optimal_flow
+  ensure
+    ORTools.unsubscribe(subscriber)
+  end
 end
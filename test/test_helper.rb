@@ -3,6 +3,7 @@ Bundler.require(:default)
 require "minitest/autorun"
 require "stringio"
 require "time"
+require "timeout"
 
 class Minitest::Test
   def setup